@@ -127,6 +127,12 @@ nk_allegro_render(enum nk_anti_aliasing AA)
 
         /* fill converting configuration */
         struct nk_convert_config config;
+        static const struct nk_draw_vertex_layout_element vertex_layout[] = {
+            {NK_VERTEX_POSITION, NK_FORMAT_FLOAT, offsetof(struct nk_allegro_vertex, pos)},
+            {NK_VERTEX_TEXCOORD, NK_FORMAT_FLOAT, offsetof(struct nk_allegro_vertex, uv)},
+            {NK_VERTEX_COLOR, NK_FORMAT_R32G32B32A32_FLOAT, offsetof(struct nk_allegro_vertex, col)},
+            {NK_VERTEX_LAYOUT_END}
+        };
         memset(&config, 0, sizeof(config));
         config.global_alpha = 1.0f;
         config.shape_AA = AA;
@@ -135,34 +141,19 @@ nk_allegro_render(enum nk_anti_aliasing AA)
         config.arc_segment_count = 22;
         config.curve_segment_count = 22;
         config.null = dev->null;
+        /* allegro uses 32-bit indices and float colors so let nuklear
+         * write directly into the allegro vertex format */
+        config.index_type = NK_INDEX_32BIT;
+        config.vertex_layout = vertex_layout;
+        config.vertex_size = sizeof(struct nk_allegro_vertex);
+        config.vertex_alignment = sizeof(float);
 
         /* convert from command into hardware format */
         nk_buffer_init_fixed(&vbuf, dev->vertex_buffer, (nk_size)dev->max_vertex_memory);
         nk_buffer_init_fixed(&ebuf, dev->element_buffer, (nk_size)dev->max_element_memory);
-            nk_convert(ctx, &dev->cmds, &vbuf, &ebuf, &config);
-
-        {
-            /* <sign> allegro does not support 32-bit packed color */
-            unsigned int i = 0;
-            struct nk_draw_vertex *verts = (struct nk_draw_vertex*)dev->vertex_buffer;
-            vertices = (struct nk_allegro_vertex*)calloc(sizeof(struct nk_allegro_vertex), ctx->draw_list.vertex_count);
-            for (i = 0; i < ctx->draw_list.vertex_count; ++i) {
-                nk_byte *c;
-                vertices[i].pos = verts[i].position;
-                vertices[i].uv = verts[i].uv;
-                c = (nk_byte*)&verts[i].col;
-                vertices[i].col = al_map_rgba(c[0], c[1], c[2], c[3]);
-            }
-        }
-        {
-            /* <massive sign> allegro does not support 16-bit indices:
-             * @OPT: define nk_draw_index as int to fix this issue. */
-            unsigned int i = 0;
-            nk_draw_index *elements = (nk_draw_index*)dev->element_buffer;
-            indices = (int*)calloc(sizeof(int), ctx->draw_list.element_count);
-            for (i = 0; i < ctx->draw_list.element_count; ++i)
-                indices[i] = elements[i];
-        }
+        nk_convert(ctx, &dev->cmds, &vbuf, &ebuf, &config);
+        vertices = (struct nk_allegro_vertex*)dev->vertex_buffer;
+        indices = (int*)dev->element_buffer;
 
         /* iterate over and execute each draw command */
         nk_draw_foreach(cmd, ctx, &dev->cmds)
@@ -176,8 +167,6 @@ nk_allegro_render(enum nk_anti_aliasing AA)
             offset += cmd->elem_count;
         }
 
-        free(vertices);
-        free(indices);
         nk_clear(ctx);
     }
     al_set_blender(op, src, dst);
@@ -105,11 +105,28 @@ OPTIONAL DEFINES:
         having a truetype font
         IMPORTANT: enabling this adds ~12kb to global stack memory
 
+    NK_NO_SIMD
+        The font baking rasterizer uses SSE2 or NEON (header <emmintrin.h> or
+        <arm_neon.h>) for scanline conversion and oversampling filters if the
+        compiler targets them. Define this to always use the portable code.
+        Both produce identical glyph images.
+
     NK_INCLUDE_COMMAND_USERDATA
         Defining this adds a userdata pointer into each command. Can be useful for
         example if you want to provide custom shader depending on the used widget.
         Can be combined with the style structures.
 
+    NK_INCLUDE_GLYPH_ADVANCE
+        Defining this adds the optional `advance` callback to `nk_user_font`
+        which is used to measure and clamp text in a single pass. Every
+        `nk_user_font` has to initialize it, either to a callback or 0.
+
+    NK_DRAW_INDEX_32
+        Defining this changes `nk_draw_index` from 16-bit to 32-bit and makes
+        32-bit indices the default element format of the vertex buffer output.
+        Each conversion can still select its index format at runtime with
+        `nk_convert_config::index_type`.
+
     NK_BUTTON_TRIGGER_ON_RELEASE
         Different platforms require button clicks occuring either on buttons being
         pressed (up to down) or released (down to up).
@@ -290,6 +307,7 @@ struct nk_allocator;
 struct nk_command_buffer;
 struct nk_draw_command;
 struct nk_convert_config;
+struct nk_convert_job;
 struct nk_text_edit;
 struct nk_draw_list;
 struct nk_user_font;
@@ -324,6 +342,13 @@ enum nk_popup_type      {NK_POPUP_STATIC, NK_POPUP_DYNAMIC};
 enum nk_layout_format   {NK_DYNAMIC, NK_STATIC};
 enum nk_tree_type       {NK_TREE_NODE, NK_TREE_TAB};
 enum nk_anti_aliasing   {NK_ANTI_ALIASING_OFF, NK_ANTI_ALIASING_ON};
+enum nk_draw_index_type {
+    NK_INDEX_DEFAULT, /* size of `nk_draw_index` (see NK_DRAW_INDEX_32) */
+    NK_INDEX_16BIT, /* 16-bit elements, wraps after 65535 vertices */
+    NK_INDEX_32BIT, /* 32-bit elements */
+    NK_INDEX_16BIT_SPLIT /* 16-bit elements, starts a new draw command with
+        a new `vertex_offset` once a batch runs out of indices */
+};
 
 struct nk_allocator {
     nk_handle userdata;
@@ -335,6 +360,44 @@ struct nk_draw_null_texture {
     nk_handle texture;/* texture handle to a texture with a white pixel */
     struct nk_vec2 uv; /* coordinates to a white pixel in the texture  */
 };
+enum nk_draw_vertex_layout_attribute {
+    NK_VERTEX_POSITION,
+    NK_VERTEX_COLOR,
+    NK_VERTEX_TEXCOORD,
+    NK_VERTEX_ATTRIBUTE_COUNT
+};
+enum nk_draw_vertex_layout_format {
+    /* two component formats for position and texture coordinates */
+    NK_FORMAT_SCHAR,
+    NK_FORMAT_SSHORT,
+    NK_FORMAT_SINT,
+    NK_FORMAT_UCHAR,
+    NK_FORMAT_USHORT,
+    NK_FORMAT_UINT,
+    NK_FORMAT_FLOAT,
+    NK_FORMAT_DOUBLE,
+    NK_FORMAT_HALF,
+    NK_FORMAT_SSHORT_NORM, /* [-1,1] mapped to [-32767,32767] */
+    NK_FORMAT_USHORT_NORM, /* [0,1] mapped to [0,65535] */
+
+    /* color formats */
+    NK_FORMAT_COLOR_BEGIN,
+    NK_FORMAT_R8G8B8 = NK_FORMAT_COLOR_BEGIN,
+    NK_FORMAT_R8G8B8A8,
+    NK_FORMAT_B8G8R8A8,
+    NK_FORMAT_R16G16B16A16,
+    NK_FORMAT_R32G32B32A32_FLOAT,
+    NK_FORMAT_RGBA32, /* packed `nk_uint` as returned by `nk_color_u32` */
+    NK_FORMAT_COLOR_END = NK_FORMAT_RGBA32,
+    NK_FORMAT_COUNT
+};
+#define NK_VERTEX_LAYOUT_END NK_VERTEX_ATTRIBUTE_COUNT,NK_FORMAT_COUNT,0
+struct nk_draw_vertex_layout_element {
+    enum nk_draw_vertex_layout_attribute attribute;
+    enum nk_draw_vertex_layout_format format;
+    nk_size offset; /* byte offset inside the vertex, aligned to the component type */
+};
+
 struct nk_convert_config {
     float global_alpha; /* global alpha value */
     enum nk_anti_aliasing line_AA; /* line anti-aliasing flag can be turned off if you are tight on memory */
@@ -342,7 +405,37 @@ struct nk_convert_config {
     unsigned int circle_segment_count; /* number of segments used for circles: default to 22 */
     unsigned int arc_segment_count; /* number of segments used for arcs: default to 22 */
     unsigned int curve_segment_count; /* number of segments used for curves: default to 22 */
+    float curve_tolerance; /* maximum distance in pixels between tessellated circles, arcs and curves and the exact shape: 0 to use the segment counts */
     struct nk_draw_null_texture null; /* handle to texture with a white pixel for shape drawing */
+    enum nk_draw_index_type index_type; /* element index format: defaults to `nk_draw_index` */
+    const struct nk_draw_vertex_layout_element *vertex_layout; /* vertex format terminated by NK_VERTEX_LAYOUT_END: 0 to output `struct nk_draw_vertex` */
+    nk_size vertex_size; /* size of one vertex in bytes for `vertex_layout` */
+    nk_size vertex_alignment; /* vertex alignment for `vertex_layout` */
+};
+
+struct nk_convert_dispatcher {
+    nk_handle userdata; /* passed to `dispatch` */
+    struct nk_allocator alloc; /* allocator for jobs and their buffers: has to be thread safe */
+    unsigned int commands_per_job; /* maximum number of commands per job: 0 for one job per window */
+    void(*dispatch)(nk_handle userdata, struct nk_convert_job *jobs, int count);
+    /* has to call `nk_convert_job_run` once for every job and may only return
+     * after all jobs have finished. Jobs do not share any state and can run
+     * concurrently on different threads. */
+};
+
+struct nk_convert_stream {
+    nk_handle userdata; /* passed to `flush` */
+    void *vertices; /* chunk memory for vertices: aligned for the vertex format */
+    nk_size vertex_capacity; /* size of each vertex chunk in bytes */
+    void *elements; /* chunk memory for elements */
+    nk_size element_capacity; /* size of each element chunk in bytes */
+    void(*flush)(nk_handle userdata, const struct nk_draw_list *list,
+        const struct nk_buffer *cmds, void **vertices, void **elements);
+    /* called for every filled chunk and the last one. Draw it with
+     * `nk_draw_list_foreach(cmd, list, cmds)` from `list->vertex_count`
+     * vertices and `list->element_count` elements inside the chunk memory.
+     * The chunk is reused after returning unless `vertices` and `elements`
+     * are pointed at the next chunk of a ring buffer */
 };
 
 enum nk_symbol_type {
@@ -514,6 +607,7 @@ NK_API int                      nk_init_custom(struct nk_context*, struct nk_buf
 NK_API int                      nk_init(struct nk_context*, struct nk_allocator*, const struct nk_user_font*);
 NK_API void                     nk_clear(struct nk_context*);
 NK_API void                     nk_free(struct nk_context*);
+NK_API void                     nk_text_cache_clear(struct nk_context*);
 #ifdef NK_INCLUDE_COMMAND_USERDATA
 NK_API void                     nk_set_user_data(struct nk_context*, nk_handle handle);
 #endif
@@ -759,6 +853,10 @@ NK_API void                     nk_menu_end(struct nk_context*);
 #define                         nk_foreach(c, ctx)for((c)=nk__begin(ctx); (c)!=0; (c)=nk__next(ctx, c))
 #ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
 NK_API void                     nk_convert(struct nk_context*, struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements, const struct nk_convert_config*);
+NK_API void                     nk_convert_parallel(struct nk_context*, struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements, const struct nk_convert_config*, const struct nk_convert_dispatcher*);
+NK_API void                     nk_convert_measure(struct nk_context*, const struct nk_convert_config*, nk_size *vertex_bytes, nk_size *element_bytes, unsigned int *cmd_count);
+NK_API void                     nk_convert_chunked(struct nk_context*, struct nk_buffer *cmds, const struct nk_convert_config*, const struct nk_convert_stream*);
+NK_API void                     nk_convert_instanced(struct nk_context*, struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements, struct nk_buffer *instances, const struct nk_convert_config*);
 #define                         nk_draw_foreach(cmd,ctx, b) for((cmd)=nk__draw_begin(ctx, b); (cmd)!=0; (cmd)=nk__draw_next(cmd, b, ctx))
 #endif
 
@@ -988,10 +1086,19 @@ NK_API nk_size nk_buffer_total(struct nk_buffer*);
  * ===============================================================*/
 /*  Basic string buffer which is only used in context with the text editor
  *  to manage and manipulate dynamic or fixed size string content. This is _NOT_
- *  the default string handling method.*/
+ *  the default string handling method.
+ *  Dynamic strings additionally store the byte offset of about every
+ *  NK_STR_CHECKPOINT_STRIDE runes at the back of their buffer, which
+ *  keeps rune indexed access from decoding the whole string.*/
+#ifndef NK_STR_CHECKPOINT_STRIDE
+#define NK_STR_CHECKPOINT_STRIDE 64
+#endif
+
 struct nk_str {
     struct nk_buffer buffer;
     int len; /* in codepoints/runes/glyphs */
+    int checkpoints; /* number of valid rune checkpoints */
+    unsigned int version; /* changed by every modification through `nk_str_*` */
 };
 
 #ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
@@ -1062,6 +1169,10 @@ NK_API int nk_str_len_char(struct nk_str*);
  * complexity I would not recommend editing gigabytes of data with it.
  * It is rather designed for uses cases which make sense for a GUI library not for
  * an full blown text editor.
+ *
+ * Text edits with an allocator additionally keep an index of line starts and
+ * row widths, which is updated lazily and only invalidated from the edited
+ * line onwards. It keeps cursor placement in long multi-line text cheap.
  */
 #ifndef NK_TEXTEDIT_UNDOSTATECOUNT
 #define NK_TEXTEDIT_UNDOSTATECOUNT     99
@@ -1071,6 +1182,10 @@ NK_API int nk_str_len_char(struct nk_str*);
 #define NK_TEXTEDIT_UNDOCHARCOUNT      999
 #endif
 
+#ifndef NK_TEXTEDIT_LINE_INITIAL_SIZE
+#define NK_TEXTEDIT_LINE_INITIAL_SIZE  1024
+#endif
+
 struct nk_text_edit;
 struct nk_clipboard {
     nk_handle userdata;
@@ -1094,6 +1209,26 @@ struct nk_text_undo_state {
    short redo_char_point;
 };
 
+struct nk_text_edit_line {
+    int begin; /* rune offset of the first character in the line */
+    int offset; /* byte offset of the first character in the line */
+    float width; /* cached row width or negative if not measured yet */
+};
+
+struct nk_text_edit_lines {
+    struct nk_buffer buffer;
+    /* line start array (only used if allocated from a dynamic buffer) */
+    int count;
+    /* number of leading lines with still valid start offsets */
+    int complete;
+    /* whether all lines up to the end of the string are indexed */
+    unsigned int version;
+    /* version of the string the index was built for */
+    nk_handle font;
+    float height;
+    /* font the cached row widths were measured with */
+};
+
 enum nk_text_edit_type {
     NK_TEXT_EDIT_SINGLE_LINE,
     NK_TEXT_EDIT_MULTI_LINE
@@ -1123,6 +1258,7 @@ struct nk_text_edit {
     unsigned char padding1;
     float preferred_x;
     struct nk_text_undo_state undo;
+    struct nk_text_edit_lines lines;
 };
 
 /* filter function */
@@ -1166,6 +1302,11 @@ NK_API void nk_textedit_redo(struct nk_text_edit*);
     fonts is best fitted for using the normal draw shape command API were you
     do all the text drawing yourself and the library does not require any kind
     of deeper knowledge about which font handling mechanism you use.
+    With `NK_INCLUDE_GLYPH_ADVANCE` you can provide an optional `advance`
+    callback returning the width of a single glyph. If set the library measures
+    and clamps text in one pass by summing glyph advances instead of measuring
+    growing substrings with `width`. So only set it if the sum of all glyph
+    advances of a string is equal to its width.
 
     While the first approach works fine if you don't want to use the optional
     vertex buffer output it is not enough if you do. To get font handling working
@@ -1194,6 +1335,7 @@ NK_API void nk_textedit_redo(struct nk_text_edit*);
 */
 struct nk_user_font_glyph;
 typedef float(*nk_text_width_f)(nk_handle, float h, const char*, int len);
+typedef float(*nk_text_advance_f)(nk_handle, float h, nk_rune codepoint, nk_rune next_codepoint);
 typedef void(*nk_query_font_glyph_f)(nk_handle handle, float font_height,
                                     struct nk_user_font_glyph *glyph,
                                     nk_rune codepoint, nk_rune next_codepoint);
@@ -1208,6 +1350,8 @@ struct nk_user_font_glyph {
     /* size of the glyph  */
     float xadvance;
     /* offset to the next glyph */
+    nk_handle texture;
+    /* texture holding the glyph: preset to `nk_user_font::texture` before each query */
 };
 #endif
 
@@ -1224,6 +1368,10 @@ struct nk_user_font {
     nk_handle texture;
     /* texture handle to the used font atlas or texture */
 #endif
+#ifdef NK_INCLUDE_GLYPH_ADVANCE
+    nk_text_advance_f advance;
+    /* optional single glyph advance in pixel callback (can be 0) */
+#endif
 };
 
 #ifdef NK_INCLUDE_FONT_BAKING
@@ -1239,6 +1387,8 @@ struct nk_baked_font {
     /* height of the font  */
     float ascent, descent;
     /* font glyphs ascent and descent  */
+    float sdf_spread;
+    /* distance range in pixel of signed distance field glyphs or 0 for coverage glyphs */
     nk_rune glyph_offset;
     /* glyph array offset inside the font glyph baking output array  */
     nk_rune glyph_count;
@@ -1263,7 +1413,9 @@ struct nk_font_config {
     /* align very character to pixel boundary (if true set oversample (1,1)) */
     unsigned char oversample_v, oversample_h;
     /* rasterize at hight quality for sub-pixel position */
-    unsigned char padding[3];
+    unsigned char sdf_spread;
+    /* if not 0 bakes signed distance field glyphs with the given distance range in pixel (disables oversampling) */
+    unsigned char padding[2];
 
     float size;
     /* baked pixel height of the font */
@@ -1284,8 +1436,43 @@ struct nk_font_glyph {
     float xadvance;
     float x0, y0, x1, y1, w, h;
     float u0, v0, u1, v1;
+    int page;
+};
+
+struct nk_font_index {
+    const nk_uint *slots;
+    /* glyph index plus one for each codepoint inside a used page (0: fallback)
+     * in the lower 24 bits and the owning font of the fallback chain (0: this
+     * font, n: `nk_font::fallbacks[n-1]`) in the upper 8 bits.
+     * The first page is always present and holds codepoints 0-255 directly */
+    const nk_ushort *pages;
+    /* maps each 256 codepoint page to its page inside `slots` */
+    nk_rune count;
+    /* number of codepoints covered by `pages` */
+};
+
+struct nk_font_kerning_pair {
+    nk_rune left, right;
+    float advance;
+    /* additional advance between both codepoints in baked font pixels */
+};
+
+struct nk_font_kerning {
+    const struct nk_font_kerning_pair *pairs;
+    /* open addressing hash table of codepoint pairs (left 0: empty slot) */
+    nk_uint capacity;
+    /* power of two number of slots in `pairs` or 0 without kerning */
 };
 
+struct nk_font_atlas_page {
+    void *pixel;
+    /* page image until `nk_font_atlas_end` */
+    int width, height;
+    nk_handle texture;
+    /* texture handle of the page set by `nk_font_atlas_end_pages` */
+};
+
+struct nk_font_cache;
 struct nk_font {
     struct nk_user_font handle;
     struct nk_baked_font info;
@@ -1294,7 +1481,16 @@ struct nk_font {
     const struct nk_font_glyph *fallback;
     nk_rune fallback_codepoint;
     nk_handle texture;
+    struct nk_font_index index;
+    struct nk_font_kerning kerning;
+    const struct nk_font_atlas_page *pages;
+    /* atlas pages to look up the texture of glyphs outside of page 0 */
+    struct nk_font *const *fallbacks;
+    /* fonts consulted in order for codepoints outside of this font's ranges */
+    int fallback_count;
     int config;
+    struct nk_font_cache *cache;
+    /* glyph cache of a dynamic font atlas or 0 if all glyphs are baked */
 };
 
 enum nk_font_atlas_format {
@@ -1302,10 +1498,28 @@ enum nk_font_atlas_format {
     NK_FONT_ATLAS_RGBA32
 };
 
+struct nk_font_bake_job {
+    struct nk_allocator alloc;
+    /* temporary allocator for rasterization: can be replaced by a per worker allocator */
+    void *baker; /* private */
+    int font, begin, count; /* private: range of packed glyphs of a font to render */
+};
+
+struct nk_font_bake_dispatcher {
+    nk_handle userdata; /* passed to `dispatch` */
+    struct nk_allocator alloc; /* allocator for the job array and default job allocator */
+    unsigned int glyphs_per_job; /* maximum number of glyphs per job: defaults to 256 if 0 */
+    void(*dispatch)(nk_handle userdata, struct nk_font_bake_job *jobs, int count);
+    /* has to call `nk_font_bake_job_run` once for every job and may only
+     * return after all jobs have finished. Jobs write disjoint parts of the
+     * image and can run concurrently on different threads. */
+};
+
 struct nk_font_atlas {
     void *pixel;
     int tex_width;
     int tex_height;
+    enum nk_font_atlas_format format;
     struct nk_allocator permanent;
     struct nk_allocator temporary;
     struct nk_recti custom;
@@ -1313,9 +1527,15 @@ struct nk_font_atlas {
     int glyph_count;
     struct nk_font *default_font;
     struct nk_font_glyph *glyphs;
+    void *glyph_index;
+    void *kerning;
     struct nk_font **fonts;
     struct nk_font_config *config;
     int font_num, font_cap;
+    struct nk_font_cache *cache;
+    struct nk_font_atlas_page *pages;
+    int page_count;
+    void *fallback;
 };
 
 /* some language glyph codepoint ranges */
@@ -1330,7 +1550,46 @@ NK_API const nk_rune *nk_font_korean_glyph_ranges(void);
  * out of font glyphs used to draw text onto the screen. This API takes away
  * some control over the baking process like fine grained memory control and
  * custom baking data but provides additional functionality and easier to
- * use and manage data structures and functions. */
+ * use and manage data structures and functions.
+ *
+ * Instead of baking every glyph of every range up front the atlas can be
+ * baked with `nk_font_atlas_bake_dynamic` into a fixed size texture page.
+ * Glyphs are then rasterized the first time they are measured or drawn and
+ * least recently used glyphs are evicted if the page runs full. The page
+ * stays alive after `nk_font_atlas_end` and `nk_font_atlas_update` has to be
+ * called once per frame after `nk_convert` to get the rectangle inside
+ * `nk_font_atlas::pixel` that changed and has to be uploaded to the texture.
+ *
+ * A baked atlas can be written into a binary blob between `nk_font_atlas_bake`
+ * and `nk_font_atlas_end` with `nk_font_atlas_save_to_memory` (returns the
+ * number of bytes required if memory is too small) or `nk_font_atlas_save`.
+ * On the next start after adding the same fonts with the same configuration
+ * `nk_font_atlas_load_from_memory` or `nk_font_atlas_load` can be called
+ * instead of `nk_font_atlas_bake`. They return 0 if the blob was created from
+ * different fonts, configuration or pixel format which requires baking.
+ *
+ * Baking packs all glyphs into the smallest power of two square that holds
+ * their area and doubles its smaller side until everything fits.
+ * `nk_font_atlas_efficiency` returns the fraction of the image used by glyphs
+ * after baking and before `nk_font_atlas_end`.
+ *
+ * Very large glyph sets like full CJK ranges can be baked with
+ * `nk_font_atlas_bake_pages` into multiple images of at most `page_width` times
+ * `page_height` texels each instead of one huge texture. Every page inside
+ * `nk_font_atlas::pages` needs its own texture and all texture handles are
+ * passed in page order to `nk_font_atlas_end_pages`, which leaves the atlas
+ * untouched if there are fewer textures than pages. Each glyph stores its
+ * page in `nk_font_glyph::page` and `nk_draw_list_add_text` only switches
+ * textures between runs of glyphs on different pages. Only single page
+ * atlases can be saved into a blob.
+ *
+ * Fonts with a non zero `nk_font_config::sdf_spread` are baked as signed
+ * distance fields instead of coverage. Each texel holds the distance to the
+ * glyph outline with the outline at 0.5 and 0/1 at `sdf_spread` pixels outside
+ * or inside. A single baked size can then be drawn at any `nk_user_font::height`
+ * if the fragment shader turns distance back into coverage, for example with
+ * `clamp((texel - 0.5) * 2 * sdf_spread * height / baked_height + 0.5, 0, 1)`
+ * using `nk_baked_font::sdf_spread` and `nk_baked_font::height`. */
 #ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
 NK_API void nk_font_atlas_init_default(struct nk_font_atlas*);
 #endif
@@ -1349,24 +1608,62 @@ NK_API struct nk_font* nk_font_atlas_add_from_file(struct nk_font_atlas *atlas,
 NK_API struct nk_font *nk_font_atlas_add_compressed(struct nk_font_atlas*, void *memory, nk_size size, float height, const struct nk_font_config*);
 NK_API struct nk_font* nk_font_atlas_add_compressed_base85(struct nk_font_atlas*, const char *data, float height, const struct nk_font_config *config);
 NK_API const void* nk_font_atlas_bake(struct nk_font_atlas*, int *width, int *height, enum nk_font_atlas_format);
+NK_API const void* nk_font_atlas_bake_parallel(struct nk_font_atlas*, int *width, int *height, enum nk_font_atlas_format, const struct nk_font_bake_dispatcher*);
+NK_API const struct nk_font_atlas_page* nk_font_atlas_bake_pages(struct nk_font_atlas*, int page_width, int page_height, enum nk_font_atlas_format, const struct nk_font_bake_dispatcher*, int *page_count);
+NK_API const void* nk_font_atlas_bake_dynamic(struct nk_font_atlas*, int width, int height, enum nk_font_atlas_format);
+NK_API int nk_font_atlas_update(struct nk_font_atlas*, struct nk_recti *dirty);
+NK_API float nk_font_atlas_efficiency(const struct nk_font_atlas*);
+NK_API nk_size nk_font_atlas_save_to_memory(const struct nk_font_atlas*, void *memory, nk_size size);
+NK_API const void* nk_font_atlas_load_from_memory(struct nk_font_atlas*, const void *memory, nk_size size, int *width, int *height, enum nk_font_atlas_format);
+#ifdef NK_INCLUDE_STANDARD_IO
+NK_API int nk_font_atlas_save(const struct nk_font_atlas*, const char *file_path);
+NK_API const void* nk_font_atlas_load(struct nk_font_atlas*, const char *file_path, int *width, int *height, enum nk_font_atlas_format);
+#endif
 NK_API void nk_font_atlas_end(struct nk_font_atlas*, nk_handle tex, struct nk_draw_null_texture*);
+NK_API void nk_font_atlas_end_pages(struct nk_font_atlas*, const nk_handle *textures, int count, struct nk_draw_null_texture*);
+NK_API int nk_font_atlas_fallback(struct nk_font_atlas*, struct nk_font*, struct nk_font *const *fallbacks, int count);
 NK_API void nk_font_atlas_clear(struct nk_font_atlas*);
 
 /* Font
  * -----------------------------------------------------------------
  * The font structure is just a simple container to hold the output of a baking
- * process in the low level API. */
+ * process in the low level API. Glyphs are looked up by walking the font
+ * codepoint ranges until a constant time lookup table is built with
+ * `nk_font_index` inside a memory block of `nk_font_index_memory` bytes.
+ * The font atlas API builds this table for every font it bakes. It also
+ * reads the pairs of the TTF `kern` table between all codepoints of a font into
+ * `nk_font::kerning` which is applied to measured and drawn text.
+ *
+ * Codepoints outside of a font's ranges can be taken from an ordered list of
+ * fallback fonts (emoji, CJK, symbols) instead of the fallback glyph.
+ * `nk_font_fallback` builds a merged lookup table over the font and all its
+ * fallbacks inside `nk_font_fallback_memory` bytes so lookups stay constant
+ * time. Every fallback keeps its own baked size and glyphs are scaled to the
+ * requested height and aligned to the baseline of the font they are drawn
+ * with. `nk_font_atlas_fallback` does the same for baked atlas fonts with
+ * memory owned by the atlas and has to be called after baking. Changing the
+ * fallbacks of a font in use requires `nk_text_cache_clear` on every context
+ * drawing with it. */
 NK_API void nk_font_init(struct nk_font*, float pixel_height, nk_rune fallback_codepoint, struct nk_font_glyph*, const struct nk_baked_font*, nk_handle atlas);
 NK_API const struct nk_font_glyph* nk_font_find_glyph(struct nk_font*, nk_rune unicode);
+NK_API float nk_font_find_kerning(const struct nk_font*, nk_rune left, nk_rune right);
+NK_API void nk_font_index_memory(nk_size *memory, const struct nk_baked_font*);
+NK_API void nk_font_index(struct nk_font*, void *memory, nk_size size);
+NK_API void nk_font_fallback_memory(nk_size *memory, const struct nk_font*, struct nk_font *const *fallbacks, int count);
+NK_API void nk_font_fallback(struct nk_font*, struct nk_font *const *fallbacks, int count, void *memory, nk_size size);
 
 /* Font baking (needs to be called sequentially top to bottom)
  * --------------------------------------------------------------------
  * This is a low level API to bake font glyphs into an image and is more
  * complex than the atlas API but provides more control over the baking
- * process with custom bake data and memory management. */
+ * process with custom bake data and memory management.
+ * `nk_font_bake_parallel` splits glyph rasterization into jobs which are
+ * run by `nk_font_bake_job_run` from a user provided dispatch callback. */
 NK_API void nk_font_bake_memory(nk_size *temporary_memory, int *glyph_count, struct nk_font_config*, int count);
 NK_API int nk_font_bake_pack(nk_size *img_memory, int *img_width, int *img_height, struct nk_recti *custom_space, void *temporary_memory, nk_size temporary_size, const struct nk_font_config*, int font_count, struct nk_allocator *alloc);
 NK_API void nk_font_bake(void *image_memory, int image_width, int image_height, void *temporary_memory, nk_size temporary_memory_size, struct nk_font_glyph*, int glyphs_count, const struct nk_font_config*, int font_count);
+NK_API void nk_font_bake_parallel(void *image_memory, int image_width, int image_height, void *temporary_memory, nk_size temporary_memory_size, struct nk_font_glyph*, int glyphs_count, const struct nk_font_config*, int font_count, const struct nk_font_bake_dispatcher*);
+NK_API void nk_font_bake_job_run(struct nk_font_bake_job*);
 NK_API void nk_font_bake_custom_data(void *img_memory, int img_width, int img_height, struct nk_recti img_dst, const char *image_data_mask, int tex_width, int tex_height,char white,char black);
 NK_API void nk_font_bake_convert(void *out_memory, int image_width, int image_height, const void *in_memory);
 
@@ -1569,12 +1866,44 @@ enum nk_command_clipping {
     NK_CLIPPING_ON = nk_true
 };
 
+#ifndef NK_TEXT_CACHE_CAPACITY
+#define NK_TEXT_CACHE_CAPACITY 0 /* power of two (>= 4) or 0 to disable */
+#endif
+#ifndef NK_TEXT_CACHE_MAX_TEXT
+#define NK_TEXT_CACHE_MAX_TEXT 32
+#endif
+
+#if NK_TEXT_CACHE_CAPACITY > 0
+/* text width cache of a context. Widths of strings up to
+ * NK_TEXT_CACHE_MAX_TEXT bytes are cached by font, height and text in sets
+ * of four entries with least recently used replacement inside each set */
+#define NK_TEXT_CACHE_WAYS 4
+struct nk_text_cache_entry {
+    nk_handle font;
+    nk_text_width_f width;
+    float height;
+    nk_hash hash;
+    int len;
+    float value;
+    unsigned int used;
+    char text[NK_TEXT_CACHE_MAX_TEXT];
+};
+
+struct nk_text_cache {
+    struct nk_text_cache_entry entries[NK_TEXT_CACHE_CAPACITY];
+    unsigned int clock;
+};
+#else
+struct nk_text_cache;
+#endif
+
 struct nk_command_buffer {
     struct nk_buffer *base;
     struct nk_rect clip;
     int use_clipping;
     nk_handle userdata;
     nk_size begin, end, last;
+    struct nk_text_cache *text_cache;
 };
 
 /* shape outlines */
@@ -1675,8 +2004,51 @@ NK_API int nk_input_is_key_down(const struct nk_input*, enum nk_keys);
     rendering API which allows a lot of ways to draw 2D content to screen.
     In fact it is probably more powerful than needed but allows even more crazy
     things than this library provides by default.
+
+    `nk_convert_parallel` produces the same output as `nk_convert` but splits
+    the command list into jobs, either one per window or chunks of
+    `nk_convert_dispatcher::commands_per_job` commands. Each job is converted
+    into its own buffers by `nk_convert_job_run` called from the user provided
+    `nk_convert_dispatcher::dispatch` callback, which can run jobs on a thread
+    pool. Afterwards all job buffers are concatenated into the output buffers.
+    Jobs call `nk_user_font::query` concurrently so it has to be thread-safe.
+    Baked fonts with a dynamic glyph cache are not: they rasterize missing
+    glyphs into the shared atlas on lookup, so if any text command uses such
+    a font the whole frame is converted serially by `nk_convert` instead.
+
+    `nk_convert_measure` computes the output size of `nk_convert` for the same
+    config without tessellating anything: the number of draw commands, the
+    exact element bytes and the vertex bytes, which include the temporary
+    memory anti-aliased shapes allocate behind their vertices. Buffers
+    created with `nk_buffer_init_fixed` over exactly these sizes never drop
+    geometry. The command buffer needs room for `cmd_count` draw commands
+    and the points of the longest path.
+
+    `nk_convert_chunked` streams the output through fixed size vertex and
+    element chunks instead of a single buffer for the whole frame. Each
+    command is measured before it is converted and if it does not fit into
+    the current chunk anymore the chunk is handed to
+    `nk_convert_stream::flush` and conversion continues with the same clip
+    rect and texture in an empty chunk. A chunk has to be large enough for
+    the biggest single shape or text. With `NK_INDEX_16BIT` chunks are also
+    flushed before 65536 vertices.
+
+    `nk_convert_instanced` is an alternative output mode which writes one
+    `nk_draw_instance` record into the `instances` buffer for every rect,
+    glyph and image instead of expanding them into vertices and elements.
+    Everything else (lines, circles, curves, polygons, multi color rects)
+    still falls back to triangles in the vertex and element buffers. A draw
+    command holds either `instance_count` instances starting at
+    `instance_offset` or `elem_count` elements, never both, so drawing all
+    commands in order keeps the painter's order. Rect instances describe the
+    shape and are expected to be rasterized and anti-aliased by the shader.
+    `nk_convert_parallel` only produces triangles.
 */
-typedef unsigned short nk_draw_index;
+#ifdef NK_DRAW_INDEX_32
+typedef nk_uint nk_draw_index;
+#else
+typedef nk_ushort nk_draw_index;
+#endif
 typedef nk_uint nk_draw_vertex_color;
 
 enum nk_draw_list_stroke {
@@ -1692,9 +2064,37 @@ struct nk_draw_vertex {
     nk_draw_vertex_color col;
 };
 
+enum nk_draw_instance_type {
+    NK_DRAW_INSTANCE_RECT,
+    /* filled or stroked rect with rounded corners */
+    NK_DRAW_INSTANCE_QUAD
+    /* textured quad for glyphs and images */
+};
+
+struct nk_draw_instance {
+    float x, y, w, h;
+    /* rect on screen: stroked rects are centered on its outline */
+    float uv[4];
+    /* texture coordinates of the top left and bottom right corner */
+    nk_draw_vertex_color col;
+    /* packed color in the same format as `nk_draw_vertex::col` */
+    float rounding;
+    /* corner radius clamped to half of the smaller side */
+    float thickness;
+    /* outline thickness: 0 for filled rects and quads */
+    unsigned int type;
+    /* enum nk_draw_instance_type */
+};
+
 struct nk_draw_command {
     unsigned int elem_count;
     /* number of elements in the current draw batch */
+    unsigned int vertex_offset;
+    /* vertex added to each element index (only non-zero for NK_INDEX_16BIT_SPLIT) */
+    unsigned int instance_offset;
+    /* index of the first instance of the batch (instanced output only) */
+    unsigned int instance_count;
+    /* number of instances in the batch: batches hold instances or elements */
     struct nk_rect clip_rect;
     /* current screen clipping rectangle */
     nk_handle texture;
@@ -1713,22 +2113,46 @@ struct nk_draw_list {
     struct nk_buffer *buffer;
     struct nk_buffer *vertices;
     struct nk_buffer *elements;
+    struct nk_buffer *instances;
+    enum nk_draw_index_type index_type;
+    const struct nk_draw_vertex_layout_element *vertex_layout;
+    nk_size vertex_size;
+    nk_size vertex_alignment;
     unsigned int element_count;
     unsigned int vertex_count;
+    unsigned int instance_count;
     nk_size cmd_offset;
     unsigned int cmd_count;
     unsigned int path_count;
     unsigned int path_offset;
-    struct nk_vec2 circle_vtx[12];
+    struct nk_vec2 circle_vtx[48];
+    float curve_tolerance;
+    float circle_tolerance;
+    nk_ushort circle_segments[64];
 #ifdef NK_INCLUDE_COMMAND_USERDATA
     nk_handle userdata;
 #endif
 };
 
+struct nk_convert_job {
+    /* private: only read and written by `nk_convert_job_run` */
+    const void *memory; /* context command memory */
+    nk_size begin; /* offset of the first command */
+    unsigned int count; /* number of commands to convert */
+    const struct nk_convert_config *config;
+    struct nk_rect clip; /* scissor rectangle active before the first command */
+    int continued; /* job continues the draw state of the previous job */
+    struct nk_draw_list list;
+    struct nk_buffer cmds;
+    struct nk_buffer vertices;
+    struct nk_buffer elements;
+};
+
 /* draw list */
 NK_API void nk_draw_list_init(struct nk_draw_list*);
 NK_API void nk_draw_list_setup(struct nk_draw_list*, float global_alpha, enum nk_anti_aliasing, enum nk_anti_aliasing, struct nk_draw_null_texture, struct nk_buffer *cmds, struct nk_buffer *vert, struct nk_buffer *elem);
 NK_API void nk_draw_list_clear(struct nk_draw_list*);
+NK_API void nk_convert_job_run(struct nk_convert_job*);
 
 /* drawing */
 #define nk_draw_list_foreach(cmd, can, b) for((cmd)=nk__draw_list_begin(can, b); (cmd)!=0; (cmd)=nk__draw_list_next(cmd, b, can))
@@ -2312,6 +2736,18 @@ struct nk_edit_state {
     unsigned char single_line;
 };
 
+#ifndef NK_EDIT_LINES_CACHE
+#define NK_EDIT_LINES_CACHE 4
+#endif
+struct nk_edit_lines {
+    struct nk_text_edit_lines lines;
+    nk_hash window, widget;
+    /* `nk_edit_string` widget the line index belongs to */
+    int length, runes;
+    /* text length in bytes and runes the line index was built for */
+    unsigned int used;
+};
+
 struct nk_property_state {
     int active, prev;
     char buffer[NK_MAX_NUMBER_BUFFER];
@@ -2344,8 +2780,8 @@ struct nk_window {
     struct nk_scaling_state scaling;
 
     struct nk_table *tables;
-    unsigned short table_count;
-    unsigned short table_size;
+    unsigned int table_count;
+    unsigned int table_size;
 
     /* window list hooks */
     struct nk_window *next;
@@ -2379,6 +2815,13 @@ struct nk_context {
      * each window for temporary use cases, so I only provide *one* instance
      * for all windows. This works because the content is cleared anyway */
     struct nk_text_edit text_edit;
+    /* line indices of the last NK_EDIT_LINES_CACHE widgets using it */
+    struct nk_edit_lines edit_lines[NK_EDIT_LINES_CACHE];
+    unsigned int edit_lines_clock;
+#if NK_TEXT_CACHE_CAPACITY > 0
+    /* widths of recently drawn text, see `nk_text_cache_clear` */
+    struct nk_text_cache text_cache;
+#endif
 
     /* windows */
     int build;
@@ -2410,6 +2853,10 @@ struct nk_context {
 #define NK_POOL_DEFAULT_CAPACITY 16
 #endif
 
+#ifndef NK_WINDOW_MAP_INITIAL_CAPACITY
+#define NK_WINDOW_MAP_INITIAL_CAPACITY 16 /* has to be a power of two */
+#endif
+
 #ifndef NK_DEFAULT_COMMAND_BUFFER_SIZE
 #define NK_DEFAULT_COMMAND_BUFFER_SIZE (4*1024)
 #endif
@@ -3334,23 +3781,22 @@ nk_murmur_hash(const void * key, int len, nk_hash seed)
 {
     /* 32-Bit MurmurHash3: https://code.google.com/p/smhasher/wiki/MurmurHash3*/
     #define NK_ROTL(x,r) ((x) << (r) | ((x) >> (32 - r)))
-    union {const nk_uint *i; const nk_byte *b;} conv = {0};
     const nk_byte *data = (const nk_byte*)key;
     const int nblocks = len/4;
     nk_uint h1 = seed;
     const nk_uint c1 = 0xcc9e2d51;
     const nk_uint c2 = 0x1b873593;
     const nk_byte *tail;
-    const nk_uint *blocks;
     nk_uint k1;
     int i;
 
-    /* body */
+    /* body: blocks are assembled from bytes since `key` can be unaligned
+     * and of any type */
     if (!key) return 0;
-    conv.b = (data + nblocks*4);
-    blocks = (const nk_uint*)conv.i;
-    for (i = -nblocks; i; ++i) {
-        k1 = blocks[i];
+    for (i = 0; i < nblocks; ++i) {
+        const nk_byte *block = data + i*4;
+        k1 = (nk_uint)block[0] | ((nk_uint)block[1] << 8) |
+            ((nk_uint)block[2] << 16) | ((nk_uint)block[3] << 24);
         k1 *= c1;
         k1 = NK_ROTL(k1,15);
         k1 *= c2;
@@ -3417,7 +3863,7 @@ nk_file_load(const char* path, nk_size* siz, struct nk_allocator *alloc)
         fclose(fd);
         return 0;
     }
-    *siz = (nk_size)fread(buf, *siz, 1, fd);
+    *siz = (nk_size)fread(buf, 1, *siz, fd);
     fclose(fd);
     return buf;
 }
@@ -3963,9 +4409,121 @@ nk_triangle_from_direction(struct nk_vec2 *result, struct nk_rect r,
     }
 }
 
+#if NK_TEXT_CACHE_CAPACITY > 0
+NK_INTERN struct nk_text_cache_entry*
+nk_text_cache_lookup(struct nk_text_cache *cache, const struct nk_user_font *font,
+    const char *text, int len, int *hit)
+{
+    /* returns the entry caching the width of `text` or on a miss the least
+     * recently used entry of the set, keyed for `text` but without value */
+    struct nk_text_cache_entry *set;
+    struct nk_text_cache_entry *entry;
+    nk_hash hash;
+    int i;
+
+    NK_ASSERT(len <= NK_TEXT_CACHE_MAX_TEXT);
+    hash = nk_murmur_hash(text, len, (nk_hash)font->userdata.id);
+    set = &cache->entries[hash & (NK_TEXT_CACHE_CAPACITY - NK_TEXT_CACHE_WAYS)];
+    entry = set;
+    for (i = 0; i < NK_TEXT_CACHE_WAYS; ++i) {
+        struct nk_text_cache_entry *e = &set[i];
+        if (e->used && e->hash == hash && e->len == len && e->height == font->height &&
+            e->font.ptr == font->userdata.ptr && e->width == font->width) {
+            /* compare the text itself since different strings can collide */
+            int j = 0;
+            while (j < len && e->text[j] == text[j]) ++j;
+            if (j == len) {
+                e->used = ++cache->clock;
+                *hit = nk_true;
+                return e;
+            }
+        }
+        if (e->used < entry->used)
+            entry = e;
+    }
+
+    /* miss: replace least recently used entry of the set */
+    entry->font = font->userdata;
+    entry->width = font->width;
+    entry->height = font->height;
+    entry->hash = hash;
+    entry->len = len;
+    entry->used = ++cache->clock;
+    NK_MEMCPY(entry->text, text, (nk_size)len);
+    *hit = nk_false;
+    return entry;
+}
+#endif
+
+NK_INTERN float
+nk_text_width(struct nk_text_cache *cache, const struct nk_user_font *font,
+    const char *text, int len)
+{
+#if NK_TEXT_CACHE_CAPACITY > 0
+    if (cache && len > 0 && len <= NK_TEXT_CACHE_MAX_TEXT) {
+        int hit;
+        struct nk_text_cache_entry *entry;
+        entry = nk_text_cache_lookup(cache, font, text, len, &hit);
+        if (!hit) entry->value = font->width(font->userdata, font->height, text, len);
+        return entry->value;
+    }
+#else
+    NK_UNUSED(cache);
+#endif
+    return font->width(font->userdata, font->height, text, len);
+}
+
+NK_INTERN float
+nk_text_glyph_width(const struct nk_user_font *font, const char *glyph,
+    int glyph_len, nk_rune unicode, nk_rune next)
+{
+#ifdef NK_INCLUDE_GLYPH_ADVANCE
+    if (font->advance)
+        return font->advance(font->userdata, font->height, unicode, next);
+#else
+    NK_UNUSED(unicode);
+    NK_UNUSED(next);
+#endif
+    return font->width(font->userdata, font->height, glyph, glyph_len);
+}
+
+NK_INTERN float
+nk_text_glyph_width_at(const struct nk_user_font *font, const char *text,
+    int glyph_len, int text_len)
+{
+    /* width of the glyph at `text` including the kerning with the glyph
+     * following it inside `text_len` bytes */
+    nk_rune unicode = 0;
+    nk_rune next = 0;
+    nk_utf_decode(text, &unicode, glyph_len);
+    nk_utf_decode(text + glyph_len, &next, text_len - glyph_len);
+    return nk_text_glyph_width(font, text, glyph_len, unicode,
+                (next == NK_UTF_INVALID) ? '\0' : next);
+}
+
+NK_INTERN float
+nk_text_prefix_width(const struct nk_user_font *font, const char *text,
+    int prefix_len, int text_len)
+{
+    /* width of the first `prefix_len` bytes of a row measured like
+     * `nk_text_calculate_text_bounds` but including the kerning with the
+     * glyph following the prefix */
+    float width = 0;
+    int len = 0;
+    while (len < prefix_len) {
+        nk_rune unicode;
+        int glyph_len = nk_utf_decode(text + len, &unicode, text_len - len);
+        if (!glyph_len) break;
+        if (unicode != '\r')
+            width += nk_text_glyph_width_at(font, text + len, glyph_len, text_len - len);
+        len += glyph_len;
+    }
+    return width;
+}
+
 NK_INTERN int
-nk_text_clamp(const struct nk_user_font *font, const char *text,
-    int text_len, float space, int *glyphs, float *text_width)
+nk_text_clamp(struct nk_text_cache *cache, const struct nk_user_font *font,
+    const char *text, int text_len, float space, int *glyphs, float *text_width)
 {
     int glyph_len = 0;
     float last_width = 0;
@@ -3975,16 +4533,49 @@ nk_text_clamp(const struct nk_user_font *font, const char *text,
     int g = 0;
 
     glyph_len = nk_utf_decode(text, &unicode, text_len);
-    while (glyph_len && (width < space) && (len < text_len)) {
-        float s;
-        len += glyph_len;
-        s = font->width(font->userdata, font->height, text, len);
-
-        last_width = width;
-        width = s;
-        glyph_len = nk_utf_decode(&text[len], &unicode, text_len - len);
-        g++;
+#ifdef NK_INCLUDE_GLYPH_ADVANCE
+    if (font->advance) {
+        /* sum up glyph advances until text does not fit anymore */
+        while (glyph_len && (width < space) && (len < text_len)) {
+            nk_rune next = 0;
+            int next_glyph_len;
+            len += glyph_len;
+            next_glyph_len = nk_utf_decode(&text[len], &next, text_len - len);
+
+            last_width = width;
+            width += font->advance(font->userdata, font->height, unicode,
+                        (next == NK_UTF_INVALID) ? '\0' : next);
+            glyph_len = next_glyph_len;
+            unicode = next;
+            g++;
+        }
+    } else
+#endif
+    {
+        /* measure growing text prefix uncached since hashing every prefix
+         * is quadratic and would flush the cache, only the result is kept */
+        while (glyph_len && (width < space) && (len < text_len)) {
+            float s;
+            len += glyph_len;
+            s = font->width(font->userdata, font->height, text, len);
+
+            last_width = width;
+            width = s;
+            glyph_len = nk_utf_decode(&text[len], &unicode, text_len - len);
+            g++;
+        }
+#if NK_TEXT_CACHE_CAPACITY > 0
+        if (cache && len > 0 && len <= NK_TEXT_CACHE_MAX_TEXT) {
+            int hit;
+            struct nk_text_cache_entry *entry;
+            entry = nk_text_cache_lookup(cache, font, text, len, &hit);
+            if (!hit) entry->value = width;
+        }
+#endif
     }
+#if NK_TEXT_CACHE_CAPACITY == 0
+    NK_UNUSED(cache);
+#endif
 
     *glyphs = g;
     *text_width = last_width;
@@ -4001,7 +4592,6 @@ nk_text_calculate_text_bounds(const struct nk_user_font *font,
     struct nk_vec2 text_size = nk_vec2(0,0);
     float line_width = 0.0f;
 
-    float glyph_width;
     int glyph_len = 0;
     nk_rune unicode = 0;
     int text_len = 0;
@@ -4010,10 +4600,11 @@ nk_text_calculate_text_bounds(const struct nk_user_font *font,
 
     glyph_len = nk_utf_decode(begin, &unicode, byte_len);
     if (!glyph_len) return text_size;
-    glyph_width = font->width(font->userdata, font->height, begin, glyph_len);
 
     *glyphs = 0;
     while ((text_len < byte_len) && glyph_len) {
+        nk_rune next = 0;
+        int next_glyph_len;
         if (unicode == '\n') {
             text_size.x = NK_MAX(text_size.x, line_width);
             text_size.y += line_height;
@@ -4034,12 +4625,15 @@ nk_text_calculate_text_bounds(const struct nk_user_font *font,
             continue;
         }
 
+        /* measure each glyph exactly once */
+        next_glyph_len = nk_utf_decode(begin + text_len + glyph_len, &next,
+                                        byte_len - (text_len + glyph_len));
+        line_width += nk_text_glyph_width(font, begin + text_len, glyph_len,
+                        unicode, (next == NK_UTF_INVALID) ? '\0' : next);
         *glyphs = *glyphs + 1;
         text_len += glyph_len;
-        line_width += (float)glyph_width;
-        glyph_width = font->width(font->userdata, font->height, begin+text_len, glyph_len);
-        glyph_len = nk_utf_decode(begin + text_len, &unicode, byte_len-text_len);
-        continue;
+        glyph_len = next_glyph_len;
+        unicode = next;
     }
 
     if (text_size.x < line_width)
@@ -4347,7 +4941,8 @@ nk_buffer_alloc(struct nk_buffer *b, enum nk_buffer_allocation_type type,
     /* check if buffer has enough memory*/
     if (type == NK_BUFFER_FRONT)
         full = ((b->allocated + size + alignment) > b->size);
-    else full = ((b->size - (size + alignment)) <= b->allocated);
+    else full = (b->size < size + alignment) ||
+        ((b->size - (size + alignment)) <= b->allocated);
 
     if (full) {
         nk_size capacity;
@@ -4358,14 +4953,15 @@ nk_buffer_alloc(struct nk_buffer *b, enum nk_buffer_allocation_type type,
 
         /* buffer is full so allocate bigger buffer if dynamic */
         capacity = (nk_size)((float)b->memory.size * b->grow_factor);
-        capacity = NK_MAX(capacity, nk_round_up_pow2((nk_uint)(b->allocated + size)));
+        capacity = NK_MAX(capacity, nk_round_up_pow2((nk_uint)(b->allocated + size +
+                    (b->memory.size - b->size))));
         b->memory.ptr = nk_buffer_realloc(b, capacity, &b->memory.size);
         if (!b->memory.ptr) return 0;
 
         /* align newly allocated pointer */
         if (type == NK_BUFFER_FRONT)
             unaligned = nk_ptr_add(void, b->memory.ptr, b->allocated);
-        else unaligned = nk_ptr_add(void, b->memory.ptr, b->size);
+        else unaligned = nk_ptr_add(void, b->memory.ptr, b->size - size);
         memory = nk_buffer_align(unaligned, align, &alignment, type);
     }
 
@@ -4495,6 +5091,8 @@ nk_str_init_default(struct nk_str *str)
     alloc.free = nk_mfree;
     nk_buffer_init(&str->buffer, &alloc, 32);
     str->len = 0;
+    str->checkpoints = 0;
+    str->version = 0;
 }
 #endif
 
@@ -4503,6 +5101,8 @@ nk_str_init(struct nk_str *str, const struct nk_allocator *alloc, nk_size size)
 {
     nk_buffer_init(&str->buffer, alloc, size);
     str->len = 0;
+    str->checkpoints = 0;
+    str->version = 0;
 }
 
 NK_API void
@@ -4510,6 +5110,179 @@ nk_str_init_fixed(struct nk_str *str, void *memory, nk_size size)
 {
     nk_buffer_init_fixed(&str->buffer, memory, size);
     str->len = 0;
+    str->checkpoints = 0;
+    str->version = 0;
+}
+
+struct nk_str_checkpoint {
+    int offset; /* byte offset of a rune */
+    int rune; /* index of the rune */
+};
+
+NK_INTERN struct nk_str_checkpoint
+nk_str_checkpoint(const struct nk_str *s, int index)
+{
+    /* checkpoints are stored in ascending order downwards from the end of
+     * the string buffer memory */
+    struct nk_str_checkpoint c;
+    const nk_byte *top = (const nk_byte*)s->buffer.memory.ptr + s->buffer.memory.size;
+    NK_MEMCPY(&c, top - (nk_size)(index + 1) * sizeof(c), sizeof(c));
+    return c;
+}
+
+NK_INTERN void
+nk_str_set_checkpoint(struct nk_str *s, int index, struct nk_str_checkpoint c)
+{
+    nk_byte *top = (nk_byte*)s->buffer.memory.ptr + s->buffer.memory.size;
+    NK_MEMCPY(top - (nk_size)(index + 1) * sizeof(c), &c, sizeof(c));
+}
+
+NK_INTERN int
+nk_str_checkpoint_before(const struct nk_str *s, int offset)
+{
+    /* index of the last checkpoint at or before byte 'offset' or -1 */
+    int low = -1, high = s->checkpoints - 1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (nk_str_checkpoint(s, mid).offset <= offset)
+            low = mid;
+        else high = mid - 1;
+    }
+    return low;
+}
+
+NK_INTERN void
+nk_str_update(struct nk_str *s, int pos, int removed, int inserted)
+{
+    /* called after 'removed' bytes at byte offset 'pos' were replaced by
+     * 'inserted' bytes. Only the runes between the checkpoints around the
+     * edit are decoded again, all checkpoints behind it are shifted by the
+     * byte and rune delta */
+    struct nk_str_checkpoint a, b, c;
+    int ia, ib, n, i, count, capacity, runes, shift;
+    int src, end, glyph_len;
+    const char *text;
+    nk_rune unicode;
+
+    s->version++;
+    text = (const char*)s->buffer.memory.ptr;
+    if (s->buffer.type != NK_BUFFER_DYNAMIC) {
+        s->len = nk_utf_len(text, (int)s->buffer.allocated);
+        s->checkpoints = 0;
+        return;
+    }
+
+    /* edited window between the surrounding checkpoints in the old string */
+    n = s->checkpoints;
+    ia = nk_str_checkpoint_before(s, pos);
+    if (ia >= 0) a = nk_str_checkpoint(s, ia);
+    else a.offset = a.rune = 0;
+    for (ib = ia + 1; ib < n && nk_str_checkpoint(s, ib).offset < pos + removed; ++ib);
+    if (ib < n) b = nk_str_checkpoint(s, ib);
+    else {
+        b.offset = (int)s->buffer.allocated - inserted + removed;
+        b.rune = s->len;
+    }
+    end = b.offset + inserted - removed;
+
+    /* count the runes of the window in the new string */
+    runes = 0;
+    src = a.offset;
+    while (src < end) {
+        glyph_len = nk_utf_decode(text + src, &unicode, end - src);
+        if (!glyph_len) break;
+        src += glyph_len;
+        runes++;
+    }
+    s->len += runes - (b.rune - a.rune);
+    count = (runes) ? (runes - 1) / NK_STR_CHECKPOINT_STRIDE: 0;
+
+    /* make room for the new checkpoints of the window */
+    shift = count - (ib - ia - 1);
+    capacity = (int)((s->buffer.memory.size - s->buffer.size) / sizeof(c));
+    if (n + shift > capacity) {
+        nk_size size = (nk_size)NK_MAX(n + shift - capacity, NK_MAX(capacity, 8)) * sizeof(c);
+        if (!nk_buffer_alloc(&s->buffer, NK_BUFFER_BACK, size, 0)) {
+            /* keep only the checkpoints in front of the edit */
+            s->checkpoints = ia + 1;
+            return;
+        }
+        text = (const char*)s->buffer.memory.ptr;
+    }
+
+    /* shift all checkpoints behind the window */
+    if (shift > 0) {
+        for (i = n - 1; i >= ib; --i) {
+            c = nk_str_checkpoint(s, i);
+            c.offset += inserted - removed;
+            c.rune += runes - (b.rune - a.rune);
+            nk_str_set_checkpoint(s, i + shift, c);
+        }
+    } else {
+        for (i = ib; i < n; ++i) {
+            c = nk_str_checkpoint(s, i);
+            c.offset += inserted - removed;
+            c.rune += runes - (b.rune - a.rune);
+            nk_str_set_checkpoint(s, i + shift, c);
+        }
+    }
+    s->checkpoints = n + shift;
+
+    /* add a checkpoint every NK_STR_CHECKPOINT_STRIDE runes inside the window */
+    i = 0;
+    src = a.offset;
+    c.rune = a.rune;
+    while (i < count) {
+        glyph_len = nk_utf_decode(text + src, &unicode, end - src);
+        src += glyph_len;
+        c.rune++;
+        if ((c.rune - a.rune) % NK_STR_CHECKPOINT_STRIDE) continue;
+        c.offset = src;
+        nk_str_set_checkpoint(s, ia + 1 + i, c);
+        i++;
+    }
+}
+
+NK_INTERN int
+nk_str_find_rune(const struct nk_str *str, int pos, nk_rune *unicode, int *len)
+{
+    /* returns the byte offset of rune 'pos' or -1 if out of bounds */
+    int i = 0;
+    int src_len = 0;
+    int glyph_len = 0;
+    const char *text;
+    int text_len;
+
+    if (str->buffer.type == NK_BUFFER_DYNAMIC && str->checkpoints) {
+        /* start decoding at the last checkpoint in front of 'pos' */
+        int low = -1, high = str->checkpoints - 1;
+        while (low < high) {
+            int mid = (low + high + 1) / 2;
+            if (nk_str_checkpoint(str, mid).rune <= pos)
+                low = mid;
+            else high = mid - 1;
+        }
+        if (low >= 0) {
+            struct nk_str_checkpoint c = nk_str_checkpoint(str, low);
+            i = c.rune;
+            src_len = c.offset;
+        }
+    }
+    text = (const char*)str->buffer.memory.ptr;
+    text_len = (int)str->buffer.allocated;
+    glyph_len = nk_utf_decode(text + src_len, unicode, text_len - src_len);
+    while (glyph_len) {
+        if (i == pos) {
+            *len = glyph_len;
+            break;
+        }
+
+        i++;
+        src_len = src_len + glyph_len;
+        glyph_len = nk_utf_decode(text + src_len, unicode, text_len - src_len);
+    }
+    if (i != pos) return -1;
+    return src_len;
 }
 
 NK_API int
@@ -4522,7 +5295,12 @@ nk_str_append_text_char(struct nk_str *s, const char *str, int len)
     mem = (char*)nk_buffer_alloc(&s->buffer, NK_BUFFER_FRONT, (nk_size)len * sizeof(char), 0);
     if (!mem) return 0;
     NK_MEMCPY(mem, str, (nk_size)len * sizeof(char));
-    s->len += nk_utf_len(str, len);
+    if (s->buffer.type == NK_BUFFER_DYNAMIC)
+        nk_str_update(s, (int)s->buffer.allocated - len, 0, len);
+    else {
+        s->len += nk_utf_len(str, len);
+        s->version++;
+    }
     return len;
 }
 
@@ -4630,7 +5408,7 @@ nk_str_insert_at_char(struct nk_str *s, int pos, const char *str, int len)
     for (i = 0; i < copylen; ++i) *dst-- = *src--;
     mem = nk_ptr_add(void, s->buffer.memory.ptr, pos);
     NK_MEMCPY(mem, str, (nk_size)len * sizeof(char));
-    s->len = nk_utf_len((char *)s->buffer.memory.ptr, (int)s->buffer.allocated);
+    nk_str_update(s, pos, 0, len);
     return 1;
 }
 
@@ -4735,7 +5513,7 @@ nk_str_remove_chars(struct nk_str *s, int len)
     if (!s || len < 0 || (nk_size)len > s->buffer.allocated) return;
     NK_ASSERT(((int)s->buffer.allocated - (int)len) >= 0);
     s->buffer.allocated -= (nk_size)len;
-    s->len = nk_utf_len((char *)s->buffer.memory.ptr, (int)s->buffer.allocated);
+    nk_str_update(s, (int)s->buffer.allocated, len, 0);
 }
 
 NK_API void
@@ -4750,7 +5528,7 @@ nk_str_remove_runes(struct nk_str *str, int len)
     NK_ASSERT(len >= 0);
     if (!str || len < 0) return;
     if (len >= str->len) {
-        str->len = 0;
+        nk_str_remove_chars(str, (int)str->buffer.allocated);
         return;
     }
 
@@ -4774,8 +5552,8 @@ nk_str_delete_chars(struct nk_str *s, int pos, int len)
         NK_MEMCPY(dst, src, s->buffer.allocated - (nk_size)(pos + len));
         NK_ASSERT(((int)s->buffer.allocated - (int)len) >= 0);
         s->buffer.allocated -= (nk_size)len;
+        nk_str_update(s, pos, len, 0);
     } else nk_str_remove_chars(s, len);
-    s->len = nk_utf_len((char *)s->buffer.memory.ptr, (int)s->buffer.allocated);
 }
 
 NK_API void
@@ -4796,9 +5574,7 @@ nk_str_delete_runes(struct nk_str *s, int pos, int len)
     temp = (char *)s->buffer.memory.ptr;
     begin = nk_str_at_rune(s, pos, &unicode, &unused);
     if (!begin) return;
-    s->buffer.memory.ptr = begin;
-    end = nk_str_at_rune(s, len, &unicode, &unused);
-    s->buffer.memory.ptr = temp;
+    end = nk_str_at_rune(s, pos + len, &unicode, &unused);
     if (!end) return;
     nk_str_delete_chars(s, (int)(begin - temp), (int)(end - begin));
 }
@@ -4814,12 +5590,7 @@ nk_str_at_char(struct nk_str *s, int pos)
 NK_API char*
 nk_str_at_rune(struct nk_str *str, int pos, nk_rune *unicode, int *len)
 {
-    int i = 0;
-    int src_len = 0;
-    int glyph_len = 0;
-    char *text;
-    int text_len;
-
+    int offset;
     NK_ASSERT(str);
     NK_ASSERT(unicode);
     NK_ASSERT(len);
@@ -4830,22 +5601,9 @@ nk_str_at_rune(struct nk_str *str, int pos, nk_rune *unicode, int *len)
         *len = 0;
         return 0;
     }
-
-    text = (char*)str->buffer.memory.ptr;
-    text_len = (int)str->buffer.allocated;
-    glyph_len = nk_utf_decode(text, unicode, text_len);
-    while (glyph_len) {
-        if (i == pos) {
-            *len = glyph_len;
-            break;
-        }
-
-        i+= glyph_len;
-        src_len = src_len + glyph_len;
-        glyph_len = nk_utf_decode(text + src_len, unicode, text_len - src_len);
-    }
-    if (i != pos) return 0;
-    return text + src_len;
+    offset = nk_str_find_rune(str, pos, unicode, len);
+    if (offset < 0) return 0;
+    return (char*)str->buffer.memory.ptr + offset;
 }
 
 NK_API const char*
@@ -4859,12 +5617,7 @@ nk_str_at_char_const(const struct nk_str *s, int pos)
 NK_API const char*
 nk_str_at_const(const struct nk_str *str, int pos, nk_rune *unicode, int *len)
 {
-    int i = 0;
-    int src_len = 0;
-    int glyph_len = 0;
-    char *text;
-    int text_len;
-
+    int offset;
     NK_ASSERT(str);
     NK_ASSERT(unicode);
     NK_ASSERT(len);
@@ -4875,22 +5628,9 @@ nk_str_at_const(const struct nk_str *str, int pos, nk_rune *unicode, int *len)
         *len = 0;
         return 0;
     }
-
-    text = (char*)str->buffer.memory.ptr;
-    text_len = (int)str->buffer.allocated;
-    glyph_len = nk_utf_decode(text, unicode, text_len);
-    while (glyph_len) {
-        if (i == pos) {
-            *len = glyph_len;
-            break;
-        }
-
-        i++;
-        src_len = src_len + glyph_len;
-        glyph_len = nk_utf_decode(text + src_len, unicode, text_len - src_len);
-    }
-    if (i != pos) return 0;
-    return text + src_len;
+    offset = nk_str_find_rune(str, pos, unicode, len);
+    if (offset < 0) return 0;
+    return (const char*)str->buffer.memory.ptr + offset;
 }
 
 NK_API nk_rune
@@ -4940,6 +5680,8 @@ nk_str_clear(struct nk_str *str)
     NK_ASSERT(str);
     nk_buffer_clear(&str->buffer);
     str->len = 0;
+    str->checkpoints = 0;
+    str->version++;
 }
 
 NK_API void
@@ -4948,6 +5690,8 @@ nk_str_free(struct nk_str *str)
     NK_ASSERT(str);
     nk_buffer_free(&str->buffer);
     str->len = 0;
+    str->checkpoints = 0;
+    str->version++;
 }
 
 /*
@@ -4969,6 +5713,7 @@ nk_command_buffer_init(struct nk_command_buffer *cmdbuf,
     cmdbuf->begin = buffer->allocated;
     cmdbuf->end = buffer->allocated;
     cmdbuf->last = buffer->allocated;
+    cmdbuf->text_cache = 0;
 }
 
 NK_INTERN void
@@ -5400,11 +6145,11 @@ nk_draw_text(struct nk_command_buffer *b, struct nk_rect r,
     }
 
     /* make sure text fits inside bounds */
-    text_width = font->width(font->userdata, font->height, string, length);
+    text_width = nk_text_width(b->text_cache, font, string, length);
     if (text_width > r.w){
         int glyphs = 0;
         float txt_width = (float)text_width;
-        length = nk_text_clamp(font, string, length, r.w, &glyphs, &txt_width);
+        length = nk_text_clamp(b->text_cache, font, string, length, r.w, &glyphs, &txt_width);
     }
 
     if (!length) return;
@@ -5453,9 +6198,15 @@ nk_draw_list_setup(struct nk_draw_list *canvas, float global_alpha,
     canvas->vertices = vertices;
     canvas->elements = elements;
     canvas->buffer = cmds;
+    canvas->instances = 0;
     canvas->line_AA = line_AA;
     canvas->shape_AA = shape_AA;
     canvas->global_alpha = global_alpha;
+    canvas->index_type = (sizeof(nk_draw_index) == 4) ? NK_INDEX_32BIT: NK_INDEX_16BIT;
+    {NK_STORAGE const nk_size vtx_align = NK_ALIGNOF(struct nk_draw_vertex);
+    canvas->vertex_layout = 0;
+    canvas->vertex_size = sizeof(struct nk_draw_vertex);
+    canvas->vertex_alignment = vtx_align;}
 }
 
 NK_API const struct nk_draw_command*
@@ -5510,14 +6261,18 @@ nk_draw_list_clear(struct nk_draw_list *list)
         nk_buffer_clear(list->vertices);
     if (list->vertices)
         nk_buffer_clear(list->elements);
+    if (list->instances)
+        nk_buffer_clear(list->instances);
 
     list->element_count = 0;
     list->vertex_count = 0;
+    list->instance_count = 0;
     list->cmd_offset = 0;
     list->cmd_count = 0;
     list->path_count = 0;
     list->vertices = 0;
     list->elements = 0;
+    list->instances = 0;
     list->clip_rect = nk_null_rect;
 }
 
@@ -5552,6 +6307,20 @@ nk_draw_list_path_last(struct nk_draw_list *list)
     return *point;
 }
 
+NK_INTERN struct nk_draw_command*
+nk_draw_list_command_last(struct nk_draw_list *list)
+{
+    void *memory;
+    nk_size size;
+    struct nk_draw_command *cmd;
+    NK_ASSERT(list->cmd_count);
+
+    memory = nk_buffer_memory(list->buffer);
+    size = nk_buffer_total(list->buffer);
+    cmd = nk_ptr_add(struct nk_draw_command, memory, size - list->cmd_offset);
+    return (cmd - (list->cmd_count-1));
+}
+
 NK_INTERN struct nk_draw_command*
 nk_draw_list_push_command(struct nk_draw_list *list, struct nk_rect clip,
     nk_handle texture)
@@ -5559,8 +6328,11 @@ nk_draw_list_push_command(struct nk_draw_list *list, struct nk_rect clip,
     NK_STORAGE const nk_size cmd_align = NK_ALIGNOF(struct nk_draw_command);
     NK_STORAGE const nk_size cmd_size = sizeof(struct nk_draw_command);
     struct nk_draw_command *cmd;
+    unsigned int vertex_offset = 0;
 
     NK_ASSERT(list);
+    if (list->cmd_count)
+        vertex_offset = nk_draw_list_command_last(list)->vertex_offset;
     cmd = (struct nk_draw_command*)
         nk_buffer_alloc(list->buffer, NK_BUFFER_BACK, cmd_size, cmd_align);
 
@@ -5573,8 +6345,14 @@ nk_draw_list_push_command(struct nk_draw_list *list, struct nk_rect clip,
     }
 
     cmd->elem_count = 0;
+    cmd->vertex_offset = vertex_offset;
+    cmd->instance_offset = list->instance_count;
+    cmd->instance_count = 0;
     cmd->clip_rect = clip;
     cmd->texture = texture;
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    cmd->userdata = list->userdata;
+#endif
 
     list->cmd_count++;
     list->clip_rect = clip;
@@ -5582,18 +6360,18 @@ nk_draw_list_push_command(struct nk_draw_list *list, struct nk_rect clip,
 }
 
 NK_INTERN struct nk_draw_command*
-nk_draw_list_command_last(struct nk_draw_list *list)
+nk_draw_list_continue_command(struct nk_draw_list *list)
 {
-    void *memory;
-    nk_size size;
-    struct nk_draw_command *cmd;
-    NK_ASSERT(list->cmd_count);
-
-    memory = nk_buffer_memory(list->buffer);
-    size = nk_buffer_total(list->buffer);
-    cmd = nk_ptr_add(struct nk_draw_command, memory, size - list->cmd_offset);
-    return (cmd - (list->cmd_count-1));
-}
+    /* starts a new batch with the same state as the last one */
+    struct nk_draw_command *cmd = nk_draw_list_command_last(list);
+    cmd = nk_draw_list_push_command(list, cmd->clip_rect, cmd->texture);
+    if (!cmd) return 0;
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    /* commands are stored backwards so the previous one follows */
+    cmd->userdata = (cmd+1)->userdata;
+#endif
+    return cmd;
+}
 
 NK_INTERN void
 nk_draw_list_add_clip(struct nk_draw_list *list, struct nk_rect rect)
@@ -5604,7 +6382,7 @@ nk_draw_list_add_clip(struct nk_draw_list *list, struct nk_rect rect)
         nk_draw_list_push_command(list, rect, list->null.texture);
     } else {
         struct nk_draw_command *prev = nk_draw_list_command_last(list);
-        if (prev->elem_count == 0)
+        if (!prev->elem_count && !prev->instance_count)
             prev->clip_rect = rect;
         nk_draw_list_push_command(list, rect, prev->texture);
     }
@@ -5619,7 +6397,7 @@ nk_draw_list_push_image(struct nk_draw_list *list, nk_handle texture)
         nk_draw_list_push_command(list, nk_null_rect, texture);
     } else {
         struct nk_draw_command *prev = nk_draw_list_command_last(list);
-        if (prev->elem_count == 0)
+        if (!prev->elem_count && !prev->instance_count)
             prev->texture = texture;
         else if (prev->texture.id != texture.id)
             nk_draw_list_push_command(list, prev->clip_rect, texture);
@@ -5639,7 +6417,7 @@ nk_draw_list_push_userdata(struct nk_draw_list *list, nk_handle userdata)
         prev->userdata = userdata;
     } else {
         struct nk_draw_command *prev = nk_draw_list_command_last(list);
-        if (prev->elem_count == 0) {
+        if (!prev->elem_count && !prev->instance_count) {
             prev->userdata = userdata;
         } else if (prev->userdata.ptr != userdata.ptr) {
             nk_draw_list_push_command(list, prev->clip_rect, prev->texture);
@@ -5650,34 +6428,84 @@ nk_draw_list_push_userdata(struct nk_draw_list *list, nk_handle userdata)
 }
 #endif
 
-NK_INTERN struct nk_draw_vertex*
+NK_INTERN void*
 nk_draw_list_alloc_vertices(struct nk_draw_list *list, nk_size count)
 {
-    struct nk_draw_vertex *vtx;
-    NK_STORAGE const nk_size vtx_align = NK_ALIGNOF(struct nk_draw_vertex);
-    NK_STORAGE const nk_size vtx_size = sizeof(struct nk_draw_vertex);
+    void *vtx;
     NK_ASSERT(list);
     if (!list) return 0;
 
-    vtx = (struct nk_draw_vertex*)
-        nk_buffer_alloc(list->vertices, NK_BUFFER_FRONT, vtx_size*count, vtx_align);
+    vtx = nk_buffer_alloc(list->vertices, NK_BUFFER_FRONT,
+        list->vertex_size*count, list->vertex_alignment);
     if (!vtx) return 0;
     list->vertex_count += (unsigned int)count;
     return vtx;
 }
 
-NK_INTERN nk_draw_index*
+NK_INTERN nk_size
+nk_draw_list_vertex_index(struct nk_draw_list *list, nk_size count)
+{
+    /* returns the element index of the next vertex to be allocated. In split
+     * mode a new batch is started if `count` vertices would overflow 16-bit */
+    struct nk_draw_command *cmd;
+    NK_ASSERT(list);
+    if (!list || !list->cmd_count) return 0;
+
+    cmd = nk_draw_list_command_last(list);
+    if (cmd->instance_count) {
+        /* triangles never share a batch with instances */
+        cmd = nk_draw_list_continue_command(list);
+        if (!cmd) return 0;
+    }
+    /* a single primitive can not be split across batches */
+    NK_ASSERT(list->index_type != NK_INDEX_16BIT_SPLIT || count <= 0xFFFF + 1);
+    if (list->index_type == NK_INDEX_16BIT_SPLIT &&
+        (list->vertex_count - cmd->vertex_offset) + count > 0xFFFF + 1) {
+        if (cmd->elem_count) {
+            cmd = nk_draw_list_continue_command(list);
+            if (!cmd) return 0;
+        }
+        cmd->vertex_offset = list->vertex_count;
+    }
+    return list->vertex_count - cmd->vertex_offset;
+}
+
+NK_INTERN struct nk_draw_instance*
+nk_draw_list_alloc_instance(struct nk_draw_list *list)
+{
+    /* appends an instance to the last batch or starts a new one if the
+     * batch already contains triangles */
+    NK_STORAGE const nk_size inst_align = NK_ALIGNOF(struct nk_draw_instance);
+    NK_STORAGE const nk_size inst_size = sizeof(struct nk_draw_instance);
+    struct nk_draw_command *cmd;
+    struct nk_draw_instance *inst;
+    NK_ASSERT(list);
+    if (!list || !list->instances || !list->cmd_count) return 0;
+
+    cmd = nk_draw_list_command_last(list);
+    if (cmd->elem_count) {
+        cmd = nk_draw_list_continue_command(list);
+        if (!cmd) return 0;
+    }
+    inst = (struct nk_draw_instance*)nk_buffer_alloc(list->instances,
+        NK_BUFFER_FRONT, inst_size, inst_align);
+    if (!inst) return 0;
+    cmd->instance_count++;
+    list->instance_count++;
+    return inst;
+}
+
+NK_INTERN void*
 nk_draw_list_alloc_elements(struct nk_draw_list *list, nk_size count)
 {
-    nk_draw_index *ids;
+    void *ids;
     struct nk_draw_command *cmd;
-    NK_STORAGE const nk_size elem_align = NK_ALIGNOF(nk_draw_index);
-    NK_STORAGE const nk_size elem_size = sizeof(nk_draw_index);
+    nk_size elem_size;
     NK_ASSERT(list);
     if (!list) return 0;
 
-    ids = (nk_draw_index*)
-        nk_buffer_alloc(list->elements, NK_BUFFER_FRONT, elem_size*count, elem_align);
+    elem_size = (list->index_type == NK_INDEX_32BIT) ? sizeof(nk_uint): sizeof(nk_ushort);
+    ids = nk_buffer_alloc(list->elements, NK_BUFFER_FRONT, elem_size*count, elem_size);
     if (!ids) return 0;
     cmd = nk_draw_list_command_last(list);
     list->element_count += (unsigned int)count;
@@ -5685,14 +6513,220 @@ nk_draw_list_alloc_elements(struct nk_draw_list *list, nk_size count)
     return ids;
 }
 
-NK_INTERN struct nk_draw_vertex
-nk_draw_vertex(struct nk_vec2 pos, struct nk_vec2 uv, nk_draw_vertex_color col)
+/* element index patterns: entries with the highest bit set index the
+ * second vertex group of a strip segment */
+NK_GLOBAL const nk_byte nk_draw_quad_indices[6] = {0,1,2, 0,2,3};
+NK_GLOBAL const nk_byte nk_draw_fringe_indices[6] = {0x80,0,1, 1,0x81,0x80};
+NK_GLOBAL const nk_byte nk_draw_line_indices[12] = {
+    0x80,0,2, 2,0x82,0x80, 0x81,1,0, 0,0x80,0x81};
+NK_GLOBAL const nk_byte nk_draw_thick_line_indices[18] = {
+    0x81,1,2, 2,0x82,0x81, 0x81,1,0, 0,0x80,0x81, 0x82,2,3, 3,0x83,0x82};
+NK_GLOBAL const nk_byte nk_draw_rect_indices[30] = {
+    0,2,4, 0,4,6, 0,6,7, 7,1,0, 2,0,1, 1,3,2, 4,2,3, 3,5,4, 6,4,5, 5,7,6};
+
+NK_INTERN void*
+nk_draw_list_push_indices(const struct nk_draw_list *list, void *ids,
+    nk_size base, const nk_byte *offsets, nk_size count)
+{
+    /* writes the `count` element indices `base + offsets[i]` */
+    nk_size i;
+    if (list->index_type == NK_INDEX_32BIT) {
+        nk_uint *dst = (nk_uint*)ids;
+        for (i = 0; i < count; ++i)
+            dst[i] = (nk_uint)(base + offsets[i]);
+        return dst + count;
+    } else {
+        nk_ushort *dst = (nk_ushort*)ids;
+        for (i = 0; i < count; ++i)
+            dst[i] = (nk_ushort)(base + offsets[i]);
+        return dst + count;
+    }
+}
+
+NK_INTERN void*
+nk_draw_list_push_fan(const struct nk_draw_list *list, void *ids,
+    nk_size base, nk_size count, nk_size step)
+{
+    /* writes a triangle fan around `base` over `count` vertices which are
+     * `step` indices apart */
+    nk_size i;
+    if (list->index_type == NK_INDEX_32BIT) {
+        nk_uint *dst = (nk_uint*)ids;
+        for (i = 2; i < count; ++i, dst += 3) {
+            dst[0] = (nk_uint)base;
+            dst[1] = (nk_uint)(base + (i - 1) * step);
+            dst[2] = (nk_uint)(base + i * step);
+        }
+        return dst;
+    } else {
+        nk_ushort *dst = (nk_ushort*)ids;
+        for (i = 2; i < count; ++i, dst += 3) {
+            dst[0] = (nk_ushort)base;
+            dst[1] = (nk_ushort)(base + (i - 1) * step);
+            dst[2] = (nk_ushort)(base + i * step);
+        }
+        return dst;
+    }
+}
+
+NK_INTERN void*
+nk_draw_list_push_strip(const struct nk_draw_list *list, void *ids,
+    nk_size base, nk_size begin, nk_size end, nk_size groups, nk_size stride,
+    const nk_byte *pattern, nk_size count)
+{
+    /* writes `pattern` for each segment in [begin,end) between the vertex
+     * groups `n` and `n + 1` of `stride` vertices. The group after the last
+     * one of `groups` wraps around to the first (never for 0 groups) */
+    nk_size i, n;
+    if (list->index_type == NK_INDEX_32BIT) {
+        nk_uint *dst = (nk_uint*)ids;
+        for (n = begin; n < end; ++n, dst += count) {
+            const nk_size a = base + n * stride;
+            const nk_size b = (n + 1 == groups) ? base: a + stride;
+            for (i = 0; i < count; ++i)
+                dst[i] = (nk_uint)(((pattern[i] & 0x80) ? b: a) + (pattern[i] & 0x7F));
+        }
+        return dst;
+    } else {
+        nk_ushort *dst = (nk_ushort*)ids;
+        for (n = begin; n < end; ++n, dst += count) {
+            const nk_size a = base + n * stride;
+            const nk_size b = (n + 1 == groups) ? base: a + stride;
+            for (i = 0; i < count; ++i)
+                dst[i] = (nk_ushort)(((pattern[i] & 0x80) ? b: a) + (pattern[i] & 0x7F));
+        }
+        return dst;
+    }
+}
+
+NK_INTERN nk_ushort
+nk_float_to_half(float value)
 {
-    struct nk_draw_vertex out;
-    out.position = pos;
-    out.uv = uv;
-    out.col = col;
-    return out;
+    union {float f; nk_uint u;} conv;
+    nk_uint sign, exponent, mantissa;
+    conv.f = value;
+    sign = (conv.u >> 16) & 0x8000;
+    exponent = (conv.u >> 23) & 0xFF;
+    mantissa = conv.u & 0x7FFFFF;
+
+    if (exponent == 0xFF) /* infinity and NaN */
+        return (nk_ushort)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    if (exponent > 142) /* overflow */
+        return (nk_ushort)(sign | 0x7C00);
+    if (exponent < 113) {
+        /* denormalized half or zero */
+        nk_uint shift = 126 - exponent;
+        if (exponent < 102) return (nk_ushort)sign;
+        mantissa |= 0x800000;
+        return (nk_ushort)(sign | ((mantissa + (1u << (shift-1))) >> shift));
+    }
+    /* round to nearest, carry may correctly overflow into the exponent */
+    return (nk_ushort)((sign | ((exponent - 112) << 10) | (mantissa >> 13))
+        + ((mantissa >> 12) & 1));
+}
+
+NK_INTERN void
+nk_draw_vertex_write_element(void *dst, const float *values,
+    enum nk_draw_vertex_layout_format format)
+{
+    int i;
+    for (i = 0; i < 2; ++i) {
+        const float v = values[i];
+        switch (format) {
+        case NK_FORMAT_SCHAR:
+            ((signed char*)dst)[i] = (signed char)NK_CLAMP(-128.0f, v, 127.0f); break;
+        case NK_FORMAT_SSHORT:
+            ((nk_short*)dst)[i] = (nk_short)NK_CLAMP(-32768.0f, v, 32767.0f); break;
+        case NK_FORMAT_SINT:
+            ((nk_int*)dst)[i] = (nk_int)v; break;
+        case NK_FORMAT_UCHAR:
+            ((nk_byte*)dst)[i] = (nk_byte)NK_CLAMP(0.0f, v, 255.0f); break;
+        case NK_FORMAT_USHORT:
+            ((nk_ushort*)dst)[i] = (nk_ushort)NK_CLAMP(0.0f, v, 65535.0f); break;
+        case NK_FORMAT_UINT:
+            ((nk_uint*)dst)[i] = (nk_uint)NK_MAX(0.0f, v); break;
+        case NK_FORMAT_FLOAT:
+            ((float*)dst)[i] = v; break;
+        case NK_FORMAT_DOUBLE:
+            ((double*)dst)[i] = (double)v; break;
+        case NK_FORMAT_HALF:
+            ((nk_ushort*)dst)[i] = nk_float_to_half(v); break;
+        case NK_FORMAT_SSHORT_NORM:
+            ((nk_short*)dst)[i] = (nk_short)(NK_CLAMP(-1.0f, v, 1.0f) * 32767.0f + ((v < 0) ? -0.5f: 0.5f)); break;
+        case NK_FORMAT_USHORT_NORM:
+            ((nk_ushort*)dst)[i] = (nk_ushort)(NK_CLAMP(0.0f, v, 1.0f) * 65535.0f + 0.5f); break;
+        default: NK_ASSERT(0 && "Invalid vertex layout format"); return;
+        }
+    }
+}
+
+NK_INTERN void
+nk_draw_vertex_write_color(void *dst, nk_draw_vertex_color col,
+    enum nk_draw_vertex_layout_format format)
+{
+    nk_byte c[4];
+    c[0] = (nk_byte)(col & 0xFF);
+    c[1] = (nk_byte)((col >> 8) & 0xFF);
+    c[2] = (nk_byte)((col >> 16) & 0xFF);
+    c[3] = (nk_byte)((col >> 24) & 0xFF);
+    switch (format) {
+    case NK_FORMAT_R8G8B8:
+    case NK_FORMAT_R8G8B8A8: {
+        nk_byte *d = (nk_byte*)dst;
+        d[0] = c[0]; d[1] = c[1]; d[2] = c[2];
+        if (format == NK_FORMAT_R8G8B8A8) d[3] = c[3];
+    } break;
+    case NK_FORMAT_B8G8R8A8: {
+        nk_byte *d = (nk_byte*)dst;
+        d[0] = c[2]; d[1] = c[1]; d[2] = c[0]; d[3] = c[3];
+    } break;
+    case NK_FORMAT_R16G16B16A16: {
+        nk_ushort *d = (nk_ushort*)dst;
+        d[0] = (nk_ushort)(c[0] * 257); d[1] = (nk_ushort)(c[1] * 257);
+        d[2] = (nk_ushort)(c[2] * 257); d[3] = (nk_ushort)(c[3] * 257);
+    } break;
+    case NK_FORMAT_R32G32B32A32_FLOAT: {
+        NK_STORAGE const float s = 1.0f/255.0f;
+        float *d = (float*)dst;
+        d[0] = (float)c[0] * s; d[1] = (float)c[1] * s;
+        d[2] = (float)c[2] * s; d[3] = (float)c[3] * s;
+    } break;
+    case NK_FORMAT_RGBA32:
+        *(nk_uint*)dst = col; break;
+    default: NK_ASSERT(0 && "Invalid vertex layout color format"); break;
+    }
+}
+
+NK_INTERN void*
+nk_draw_vertex(void *dst, const struct nk_draw_list *list,
+    struct nk_vec2 pos, struct nk_vec2 uv, nk_draw_vertex_color col)
+{
+    /* writes one vertex in the list's vertex layout and returns the next vertex */
+    const struct nk_draw_vertex_layout_element *elem = list->vertex_layout;
+    if (!elem) {
+        struct nk_draw_vertex *out = (struct nk_draw_vertex*)dst;
+        out->position = pos;
+        out->uv = uv;
+        out->col = col;
+        return out + 1;
+    }
+    for (; elem->attribute != NK_VERTEX_ATTRIBUTE_COUNT; ++elem) {
+        void *address = (void*)((nk_byte*)dst + elem->offset);
+        switch (elem->attribute) {
+        case NK_VERTEX_POSITION: {
+            float v[2]; v[0] = pos.x; v[1] = pos.y;
+            nk_draw_vertex_write_element(address, v, elem->format);
+        } break;
+        case NK_VERTEX_TEXCOORD: {
+            float v[2]; v[0] = uv.x; v[1] = uv.y;
+            nk_draw_vertex_write_element(address, v, elem->format);
+        } break;
+        case NK_VERTEX_COLOR:
+            nk_draw_vertex_write_color(address, col, elem->format); break;
+        default: NK_ASSERT(0 && "wrong vertex layout attribute"); break;
+        }
+    }
+    return (void*)((nk_byte*)dst + list->vertex_size);
 }
 
 NK_API void
@@ -5726,11 +6760,11 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
         /* allocate vertices and elements  */
         nk_size i1 = 0;
         nk_size vertex_offset;
-        nk_size index = list->vertex_count;
         const nk_size idx_count = (thick_line) ?  (count * 18) : (count * 12);
         const nk_size vtx_count = (thick_line) ? (points_count * 4): (points_count *3);
-        struct nk_draw_vertex *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
-        nk_draw_index *ids = nk_draw_list_alloc_elements(list, idx_count);
+        nk_size index = nk_draw_list_vertex_index(list, vtx_count);
+        void *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
+        void *ids = nk_draw_list_alloc_elements(list, idx_count);
 
         nk_size size;
         struct nk_vec2 *normals, *temp;
@@ -5745,7 +6779,7 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
             nk_buffer_alloc(list->vertices, NK_BUFFER_FRONT, size, pnt_align);
         NK_ASSERT(normals);
         if (!normals) return;
-        vtx = (struct nk_draw_vertex*)(void*)((nk_byte*)list->vertices->memory.ptr + vertex_offset);
+        vtx = (void*)((nk_byte*)list->vertices->memory.ptr + vertex_offset);
         temp = normals + points_count;
 
         /* calculate normals */
@@ -5769,7 +6803,7 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
             normals[points_count-1] = normals[points_count-2];
 
         if (!thick_line) {
-            nk_size idx1, i;
+            nk_size i;
             if (!closed) {
                 struct nk_vec2 d;
                 temp[0] = nk_vec2_add(points[0], nk_vec2_muls(normals[0], AA_SIZE));
@@ -5780,12 +6814,12 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
             }
 
             /* fill elements */
-            idx1 = index;
+            nk_draw_list_push_strip(list, ids, index, 0, count, points_count, 3,
+                nk_draw_line_indices, 12);
             for (i1 = 0; i1 < count; i1++) {
                 struct nk_vec2 dm;
                 float dmr2;
                 nk_size i2 = ((i1 + 1) == points_count) ? 0 : (i1 + 1);
-                nk_size idx2 = ((i1+1) == points_count) ? index: (idx1 + 3);
 
                 /* average normals */
                 dm = nk_vec2_muls(nk_vec2_add(normals[i1], normals[i2]), 0.5f);
@@ -5799,27 +6833,17 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
                 dm = nk_vec2_muls(dm, AA_SIZE);
                 temp[i2*2+0] = nk_vec2_add(points[i2], dm);
                 temp[i2*2+1] = nk_vec2_sub(points[i2], dm);
-
-                ids[0] = (nk_draw_index)(idx2 + 0); ids[1] = (nk_draw_index)(idx1+0);
-                ids[2] = (nk_draw_index)(idx1 + 2); ids[3] = (nk_draw_index)(idx1+2);
-                ids[4] = (nk_draw_index)(idx2 + 2); ids[5] = (nk_draw_index)(idx2+0);
-                ids[6] = (nk_draw_index)(idx2 + 1); ids[7] = (nk_draw_index)(idx1+1);
-                ids[8] = (nk_draw_index)(idx1 + 0); ids[9] = (nk_draw_index)(idx1+0);
-                ids[10]= (nk_draw_index)(idx2 + 0); ids[11]= (nk_draw_index)(idx2+1);
-                ids += 12;
-                idx1 = idx2;
             }
 
             /* fill vertices */
             for (i = 0; i < points_count; ++i) {
                 const struct nk_vec2 uv = list->null.uv;
-                vtx[0] = nk_draw_vertex(points[i], uv, col);
-                vtx[1] = nk_draw_vertex(temp[i*2+0], uv, col_trans);
-                vtx[2] = nk_draw_vertex(temp[i*2+1], uv, col_trans);
-                vtx += 3;
+                vtx = nk_draw_vertex(vtx, list, points[i], uv, col);
+                vtx = nk_draw_vertex(vtx, list, temp[i*2+0], uv, col_trans);
+                vtx = nk_draw_vertex(vtx, list, temp[i*2+1], uv, col_trans);
             }
         } else {
-            nk_size idx1, i;
+            nk_size i;
             const float half_inner_thickness = (thickness - AA_SIZE) * 0.5f;
             if (!closed) {
                 struct nk_vec2 d1 = nk_vec2_muls(normals[0], half_inner_thickness + AA_SIZE);
@@ -5840,11 +6864,11 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
             }
 
             /* add all elements */
-            idx1 = index;
+            nk_draw_list_push_strip(list, ids, index, 0, count, points_count, 4,
+                nk_draw_thick_line_indices, 18);
             for (i1 = 0; i1 < count; ++i1) {
                 struct nk_vec2 dm_out, dm_in;
                 const nk_size i2 = ((i1+1) == points_count) ? 0: (i1 + 1);
-                nk_size idx2 = ((i1+1) == points_count) ? index: (idx1 + 4);
 
                 /* average normals */
                 struct nk_vec2 dm = nk_vec2_muls(nk_vec2_add(normals[i1], normals[i2]), 0.5f);
@@ -5861,29 +6885,15 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
                 temp[i2*4+1] = nk_vec2_add(points[i2], dm_in);
                 temp[i2*4+2] = nk_vec2_sub(points[i2], dm_in);
                 temp[i2*4+3] = nk_vec2_sub(points[i2], dm_out);
-
-                /* add indexes */
-                ids[0] = (nk_draw_index)(idx2 + 1); ids[1] = (nk_draw_index)(idx1+1);
-                ids[2] = (nk_draw_index)(idx1 + 2); ids[3] = (nk_draw_index)(idx1+2);
-                ids[4] = (nk_draw_index)(idx2 + 2); ids[5] = (nk_draw_index)(idx2+1);
-                ids[6] = (nk_draw_index)(idx2 + 1); ids[7] = (nk_draw_index)(idx1+1);
-                ids[8] = (nk_draw_index)(idx1 + 0); ids[9] = (nk_draw_index)(idx1+0);
-                ids[10]= (nk_draw_index)(idx2 + 0); ids[11] = (nk_draw_index)(idx2+1);
-                ids[12]= (nk_draw_index)(idx2 + 2); ids[13] = (nk_draw_index)(idx1+2);
-                ids[14]= (nk_draw_index)(idx1 + 3); ids[15] = (nk_draw_index)(idx1+3);
-                ids[16]= (nk_draw_index)(idx2 + 3); ids[17] = (nk_draw_index)(idx2+2);
-                ids += 18;
-                idx1 = idx2;
             }
 
             /* add vertices */
             for (i = 0; i < points_count; ++i) {
                 const struct nk_vec2 uv = list->null.uv;
-                vtx[0] = nk_draw_vertex(temp[i*4+0], uv, col_trans);
-                vtx[1] = nk_draw_vertex(temp[i*4+1], uv, col);
-                vtx[2] = nk_draw_vertex(temp[i*4+2], uv, col);
-                vtx[3] = nk_draw_vertex(temp[i*4+3], uv, col_trans);
-                vtx += 4;
+                vtx = nk_draw_vertex(vtx, list, temp[i*4+0], uv, col_trans);
+                vtx = nk_draw_vertex(vtx, list, temp[i*4+1], uv, col);
+                vtx = nk_draw_vertex(vtx, list, temp[i*4+2], uv, col);
+                vtx = nk_draw_vertex(vtx, list, temp[i*4+3], uv, col_trans);
             }
         }
 
@@ -5892,13 +6902,15 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
     } else {
         /* NON ANTI-ALIASED STROKE */
         nk_size i1 = 0;
-        nk_size idx = list->vertex_count;
         const nk_size idx_count = count * 6;
         const nk_size vtx_count = count * 4;
-        struct nk_draw_vertex *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
-        nk_draw_index *ids = nk_draw_list_alloc_elements(list, idx_count);
+        nk_size idx = nk_draw_list_vertex_index(list, vtx_count);
+        void *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
+        void *ids = nk_draw_list_alloc_elements(list, idx_count);
         if (!vtx || !ids) return;
 
+        nk_draw_list_push_strip(list, ids, idx, 0, count, 0, 4,
+            nk_draw_quad_indices, 6);
         for (i1 = 0; i1 < count; ++i1) {
             float dx, dy;
             const struct nk_vec2 uv = list->null.uv;
@@ -5919,19 +6931,231 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
             dx = diff.x * (thickness * 0.5f);
             dy = diff.y * (thickness * 0.5f);
 
-            vtx[0] = nk_draw_vertex(nk_vec2(p1.x + dy, p1.y - dx), uv, col);
-            vtx[1] = nk_draw_vertex(nk_vec2(p2.x + dy, p2.y - dx), uv, col);
-            vtx[2] = nk_draw_vertex(nk_vec2(p2.x - dy, p2.y + dx), uv, col);
-            vtx[3] = nk_draw_vertex(nk_vec2(p1.x - dy, p1.y + dx), uv, col);
-            vtx += 4;
-
-            ids[0] = (nk_draw_index)(idx+0); ids[1] = (nk_draw_index)(idx+1);
-            ids[2] = (nk_draw_index)(idx+2); ids[3] = (nk_draw_index)(idx+0);
-            ids[4] = (nk_draw_index)(idx+2); ids[5] = (nk_draw_index)(idx+3);
-            ids += 6;
-            idx += 4;
+            vtx = nk_draw_vertex(vtx, list, nk_vec2(p1.x + dy, p1.y - dx), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2(p2.x + dy, p2.y - dx), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2(p2.x - dy, p2.y + dx), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2(p1.x - dy, p1.y + dx), uv, col);
+        }
+    }
+}
+
+NK_INTERN void
+nk_draw_list_push_vertices(struct nk_draw_list *list, void *vtx,
+    const struct nk_vec2 *pos, const nk_draw_vertex_color *col, int count)
+{
+    /* writes vertices with the null texture coordinate */
+    int i;
+    if (!list->vertex_layout) {
+        struct nk_draw_vertex *out = (struct nk_draw_vertex*)vtx;
+        for (i = 0; i < count; ++i) {
+            out[i].position = pos[i];
+            out[i].uv = list->null.uv;
+            out[i].col = col[i];
+        }
+        return;
+    }
+    for (i = 0; i < count; ++i)
+        vtx = nk_draw_vertex(vtx, list, pos[i], list->null.uv, col[i]);
+}
+
+NK_INTERN void
+nk_draw_list_shape_state(struct nk_draw_list *list)
+{
+    /* same command state as a path */
+    struct nk_draw_command *cmd;
+    if (!list->cmd_count)
+        nk_draw_list_add_clip(list, nk_null_rect);
+    cmd = nk_draw_list_command_last(list);
+    if (cmd && cmd->texture.ptr != list->null.texture.ptr)
+        nk_draw_list_push_image(list, list->null.texture);
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    nk_draw_list_push_userdata(list, list->userdata);
+#endif
+}
+
+NK_INTERN int
+nk_draw_list_rect_instance(struct nk_draw_list *list, struct nk_rect rect,
+    struct nk_color color, float rounding, float thickness)
+{
+    /* emits an axis aligned rect as a single instance */
+    struct nk_draw_instance *inst;
+    if (rect.w <= 0.0f || rect.h <= 0.0f || thickness < 0.0f || list->path_count)
+        return nk_false;
+
+    nk_draw_list_shape_state(list);
+    inst = nk_draw_list_alloc_instance(list);
+    if (!inst) return nk_true;
+    color.a = (nk_byte)((float)color.a * list->global_alpha);
+    inst->x = rect.x + 0.5f;
+    inst->y = rect.y + 0.5f;
+    inst->w = rect.w;
+    inst->h = rect.h;
+    inst->uv[0] = inst->uv[2] = list->null.uv.x;
+    inst->uv[1] = inst->uv[3] = list->null.uv.y;
+    inst->col = nk_color_u32(color);
+    inst->rounding = NK_CLAMP(0.0f, rounding, NK_MIN(rect.w, rect.h) * 0.5f);
+    inst->thickness = thickness;
+    inst->type = NK_DRAW_INSTANCE_RECT;
+    return nk_true;
+}
+
+NK_INTERN int
+nk_draw_list_rect_shape(struct nk_draw_list *list, struct nk_vec2 a,
+    struct nk_vec2 b, struct nk_vec2 *pnt, struct nk_vec2 *dm)
+{
+    /* Corners of an axis aligned rect in path order together with the
+     * averaged corner normals of polygon paths. The edge normals are the
+     * axes, so all four corner normals share their magnitude and are
+     * computed once with the same normalization as `nk_draw_list_path_fill`
+     * which keeps the output identical */
+    NK_STORAGE const float sx[4] = {-1.0f, 1.0f, 1.0f,-1.0f};
+    NK_STORAGE const float sy[4] = {-1.0f,-1.0f, 1.0f, 1.0f};
+    const float w = b.x - a.x;
+    const float h = b.y - a.y;
+    float nx, ny, dmr2;
+    int i;
+    if (w <= 0.0f || h <= 0.0f || list->path_count)
+        return nk_false;
+
+    nk_draw_list_shape_state(list);
+    pnt[0] = a; pnt[1] = nk_vec2(b.x, a.y);
+    pnt[2] = b; pnt[3] = nk_vec2(a.x, b.y);
+    nx = (h * nk_inv_sqrt(h*h)) * 0.5f;
+    ny = (w * nk_inv_sqrt(w*w)) * 0.5f;
+    dmr2 = nx*nx + ny*ny;
+    if (dmr2 > 0.000001f) {
+        float scale = 1.0f / dmr2;
+        scale = NK_MIN(scale, 100.0f);
+        nx = nx * scale;
+        ny = ny * scale;
+    }
+    for (i = 0; i < 4; ++i)
+        dm[i] = nk_vec2(sx[i] * nx, sy[i] * ny);
+    return nk_true;
+}
+
+NK_INTERN int
+nk_draw_list_fill_rect_fast(struct nk_draw_list *list, struct nk_vec2 a,
+    struct nk_vec2 b, struct nk_color color)
+{
+    /* emits a filled axis aligned rect without going through a path */
+    struct nk_vec2 pnt[4], dm[4], pos[8];
+    nk_draw_vertex_color col[8];
+    nk_draw_vertex_color c;
+    nk_size index;
+    void *vtx, *ids;
+    int i;
+
+    if (!nk_draw_list_rect_shape(list, a, b, pnt, dm))
+        return nk_false;
+    color.a = (nk_byte)((float)color.a * list->global_alpha);
+    c = nk_color_u32(color);
+    if (list->shape_AA == NK_ANTI_ALIASING_ON) {
+        /* inner quad and a fringe of one pixel */
+        index = nk_draw_list_vertex_index(list, 8);
+        vtx = nk_draw_list_alloc_vertices(list, 8);
+        ids = nk_draw_list_alloc_elements(list, 30);
+        if (!vtx || !ids) return nk_true;
+        for (i = 0; i < 4; ++i) {
+            struct nk_vec2 d = nk_vec2_muls(dm[i], 0.5f);
+            pos[i*2+0] = nk_vec2_sub(pnt[i], d);
+            pos[i*2+1] = nk_vec2_add(pnt[i], d);
+            col[i*2+0] = c;
+            col[i*2+1] = c & 0x00ffffff;
+        }
+        nk_draw_list_push_vertices(list, vtx, pos, col, 8);
+        nk_draw_list_push_indices(list, ids, index, nk_draw_rect_indices, 30);
+    } else {
+        index = nk_draw_list_vertex_index(list, 4);
+        vtx = nk_draw_list_alloc_vertices(list, 4);
+        ids = nk_draw_list_alloc_elements(list, 6);
+        if (!vtx || !ids) return nk_true;
+        for (i = 0; i < 4; ++i) col[i] = c;
+        nk_draw_list_push_vertices(list, vtx, pnt, col, 4);
+        nk_draw_list_push_indices(list, ids, index, nk_draw_quad_indices, 6);
+    }
+    return nk_true;
+}
+
+NK_INTERN int
+nk_draw_list_stroke_rect_fast(struct nk_draw_list *list, struct nk_vec2 a,
+    struct nk_vec2 b, struct nk_color color, float thickness)
+{
+    /* emits an axis aligned rect outline without going through a path */
+    struct nk_vec2 pnt[4], dm[4], pos[16];
+    nk_draw_vertex_color col[16];
+    nk_draw_vertex_color c, c_trans;
+    nk_size index;
+    void *vtx, *ids;
+    int i;
+
+    if (!nk_draw_list_rect_shape(list, a, b, pnt, dm))
+        return nk_false;
+    color.a = (nk_byte)((float)color.a * list->global_alpha);
+    c = nk_color_u32(color);
+    c_trans = c & 0x00ffffff;
+    if (list->line_AA == NK_ANTI_ALIASING_ON && thickness <= 1.0f) {
+        /* thin line: center and one fringe vertex on each side */
+        index = nk_draw_list_vertex_index(list, 12);
+        vtx = nk_draw_list_alloc_vertices(list, 12);
+        ids = nk_draw_list_alloc_elements(list, 48);
+        if (!vtx || !ids) return nk_true;
+        for (i = 0; i < 4; ++i) {
+            pos[i*3+0] = pnt[i];
+            pos[i*3+1] = nk_vec2_add(pnt[i], dm[i]);
+            pos[i*3+2] = nk_vec2_sub(pnt[i], dm[i]);
+            col[i*3+0] = c; col[i*3+1] = c_trans; col[i*3+2] = c_trans;
+        }
+        nk_draw_list_push_vertices(list, vtx, pos, col, 12);
+        nk_draw_list_push_strip(list, ids, index, 0, 4, 4, 3,
+            nk_draw_line_indices, 12);
+    } else if (list->line_AA == NK_ANTI_ALIASING_ON) {
+        /* thick line: inner band with fringes on both sides */
+        const float half_inner_thickness = (thickness - 1.0f) * 0.5f;
+        index = nk_draw_list_vertex_index(list, 16);
+        vtx = nk_draw_list_alloc_vertices(list, 16);
+        ids = nk_draw_list_alloc_elements(list, 72);
+        if (!vtx || !ids) return nk_true;
+        for (i = 0; i < 4; ++i) {
+            struct nk_vec2 dm_out = nk_vec2_muls(dm[i], half_inner_thickness + 1.0f);
+            struct nk_vec2 dm_in = nk_vec2_muls(dm[i], half_inner_thickness);
+            pos[i*4+0] = nk_vec2_add(pnt[i], dm_out);
+            pos[i*4+1] = nk_vec2_add(pnt[i], dm_in);
+            pos[i*4+2] = nk_vec2_sub(pnt[i], dm_in);
+            pos[i*4+3] = nk_vec2_sub(pnt[i], dm_out);
+            col[i*4+0] = c_trans; col[i*4+1] = c;
+            col[i*4+2] = c; col[i*4+3] = c_trans;
         }
+        nk_draw_list_push_vertices(list, vtx, pos, col, 16);
+        nk_draw_list_push_strip(list, ids, index, 0, 4, 4, 4,
+            nk_draw_thick_line_indices, 18);
+    } else {
+        /* one quad for each edge */
+        const float w = (b.x - a.x) * nk_inv_sqrt((b.x - a.x) * (b.x - a.x));
+        const float h = (b.y - a.y) * nk_inv_sqrt((b.y - a.y) * (b.y - a.y));
+        index = nk_draw_list_vertex_index(list, 16);
+        vtx = nk_draw_list_alloc_vertices(list, 16);
+        ids = nk_draw_list_alloc_elements(list, 24);
+        if (!vtx || !ids) return nk_true;
+        for (i = 0; i < 4; ++i) {
+            /* edge direction along the axes scaled to half the thickness */
+            NK_STORAGE const float ex[4] = {1.0f, 0.0f,-1.0f, 0.0f};
+            NK_STORAGE const float ey[4] = {0.0f, 1.0f, 0.0f,-1.0f};
+            const struct nk_vec2 p1 = pnt[i];
+            const struct nk_vec2 p2 = pnt[(i + 1) & 3];
+            const float dx = (ex[i] * w) * (thickness * 0.5f);
+            const float dy = (ey[i] * h) * (thickness * 0.5f);
+            pos[i*4+0] = nk_vec2(p1.x + dy, p1.y - dx);
+            pos[i*4+1] = nk_vec2(p2.x + dy, p2.y - dx);
+            pos[i*4+2] = nk_vec2(p2.x - dy, p2.y + dx);
+            pos[i*4+3] = nk_vec2(p1.x - dy, p1.y + dx);
+            col[i*4+0] = col[i*4+1] = col[i*4+2] = col[i*4+3] = c;
+        }
+        nk_draw_list_push_vertices(list, vtx, pos, col, 16);
+        nk_draw_list_push_strip(list, ids, index, 0, 4, 0, 4,
+            nk_draw_quad_indices, 6);
     }
+    return nk_true;
 }
 
 NK_API void
@@ -5952,21 +7176,18 @@ nk_draw_list_fill_poly_convex(struct nk_draw_list *list,
     color.a = (nk_byte)((float)color.a * list->global_alpha);
     col = nk_color_u32(color);
     if (aliasing == NK_ANTI_ALIASING_ON) {
-        nk_size i = 0;
         nk_size i0 = 0;
         nk_size i1 = 0;
 
         const float AA_SIZE = 1.0f;
         nk_size vertex_offset = 0;
         const nk_draw_vertex_color col_trans = col & 0x00ffffff;
-        nk_size index = list->vertex_count;
         const nk_size idx_count = (points_count-2)*3 + points_count*6;
         const nk_size vtx_count = (points_count*2);
-        struct nk_draw_vertex *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
-        nk_draw_index *ids = nk_draw_list_alloc_elements(list, idx_count);
+        nk_size index = nk_draw_list_vertex_index(list, vtx_count);
+        void *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
+        void *ids = nk_draw_list_alloc_elements(list, idx_count);
 
-        unsigned int vtx_inner_idx = (unsigned int)(index + 0);
-        unsigned int vtx_outer_idx = (unsigned int)(index + 1);
         struct nk_vec2 *normals = 0;
         nk_size size = 0;
         if (!vtx || !ids) return;
@@ -5979,15 +7200,15 @@ nk_draw_list_fill_poly_convex(struct nk_draw_list *list,
             nk_buffer_alloc(list->vertices, NK_BUFFER_FRONT, size, pnt_align);
         NK_ASSERT(normals);
         if (!normals) return;
-        vtx = (struct nk_draw_vertex*)(void*)((nk_byte*)list->vertices->memory.ptr + vertex_offset);
-
-        /* add elements */
-        for (i = 2; i < points_count; i++) {
-            ids[0] = (nk_draw_index)(vtx_inner_idx);
-            ids[1] = (nk_draw_index)(vtx_inner_idx + ((i-1) << 1));
-            ids[2] = (nk_draw_index)(vtx_inner_idx + (i << 1));
-            ids += 3;
-        }
+        vtx = (void*)((nk_byte*)list->vertices->memory.ptr + vertex_offset);
+
+        /* add elements: inner fan, then the fringe of each edge starting
+         * with the closing one */
+        ids = nk_draw_list_push_fan(list, ids, index, points_count, 2);
+        ids = nk_draw_list_push_strip(list, ids, index, points_count-1,
+            points_count, points_count, 2, nk_draw_fringe_indices, 6);
+        nk_draw_list_push_strip(list, ids, index, 0, points_count-1,
+            points_count, 2, nk_draw_fringe_indices, 6);
 
         /* compute normals */
         for (i0 = points_count-1, i1 = 0; i1 < points_count; i0 = i1++) {
@@ -6006,7 +7227,7 @@ nk_draw_list_fill_poly_convex(struct nk_draw_list *list,
             normals[i0].y = -diff.x;
         }
 
-        /* add vertices + indexes */
+        /* add vertices */
         for (i0 = points_count-1, i1 = 0; i1 < points_count; i0 = i1++) {
             const struct nk_vec2 uv = list->null.uv;
             struct nk_vec2 n0 = normals[i0];
@@ -6021,40 +7242,23 @@ nk_draw_list_fill_poly_convex(struct nk_draw_list *list,
             }
             dm = nk_vec2_muls(dm, AA_SIZE * 0.5f);
 
-            /* add vertices */
-            vtx[0] = nk_draw_vertex(nk_vec2_sub(points[i1], dm), uv, col);
-            vtx[1] = nk_draw_vertex(nk_vec2_add(points[i1], dm), uv, col_trans);
-            vtx += 2;
-
-            /* add indexes */
-            ids[0] = (nk_draw_index)(vtx_inner_idx+(i1<<1));
-            ids[1] = (nk_draw_index)(vtx_inner_idx+(i0<<1));
-            ids[2] = (nk_draw_index)(vtx_outer_idx+(i0<<1));
-            ids[3] = (nk_draw_index)(vtx_outer_idx+(i0<<1));
-            ids[4] = (nk_draw_index)(vtx_outer_idx+(i1<<1));
-            ids[5] = (nk_draw_index)(vtx_inner_idx+(i1<<1));
-            ids += 6;
+            vtx = nk_draw_vertex(vtx, list, nk_vec2_sub(points[i1], dm), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2_add(points[i1], dm), uv, col_trans);
         }
         /* free temporary normals + points */
         nk_buffer_reset(list->vertices, NK_BUFFER_FRONT);
     } else {
         nk_size i = 0;
-        nk_size index = list->vertex_count;
         const nk_size idx_count = (points_count-2)*3;
         const nk_size vtx_count = points_count;
-        struct nk_draw_vertex *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
-        nk_draw_index *ids = nk_draw_list_alloc_elements(list, idx_count);
+        nk_size index = nk_draw_list_vertex_index(list, vtx_count);
+        void *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
+        void *ids = nk_draw_list_alloc_elements(list, idx_count);
         if (!vtx || !ids) return;
         for (i = 0; i < vtx_count; ++i) {
-            vtx[0] = nk_draw_vertex(points[i], list->null.uv, col);
-            vtx++;
-        }
-        for (i = 2; i < points_count; ++i) {
-            ids[0] = (nk_draw_index)index;
-            ids[1] = (nk_draw_index)(index+ i - 1);
-            ids[2] = (nk_draw_index)(index+i);
-            ids += 3;
+            vtx = nk_draw_vertex(vtx, list, points[i], list->null.uv, col);
         }
+        nk_draw_list_push_fan(list, ids, index, points_count, 1);
     }
 }
 
@@ -6081,21 +7285,62 @@ nk_draw_list_path_line_to(struct nk_draw_list *list, struct nk_vec2 pos)
     cmd = nk_draw_list_command_last(list);
     if (cmd && cmd->texture.ptr != list->null.texture.ptr)
         nk_draw_list_push_image(list, list->null.texture);
+    else if (cmd && cmd->instance_count)
+        /* split before the path is allocated since new commands can
+         * move the buffer the path points live in */
+        nk_draw_list_continue_command(list);
 
     points = nk_draw_list_alloc_path(list, 1);
     if (!points) return;
     points[0] = pos;
 }
 
-NK_API void
-nk_draw_list_path_arc_to_fast(struct nk_draw_list *list, struct nk_vec2 center,
-    float radius, int a_min, int a_max)
+#define NK_CIRCLE_SEGMENTS_MIN 4
+#define NK_CIRCLE_SEGMENTS_MAX 512
+
+NK_INTERN unsigned int
+nk_draw_list_calc_segments(float radius, float tolerance, unsigned int table)
 {
-    NK_ASSERT(list);
-    if (!list) return;
+    /* number of circle segments for chords to stay within `tolerance`
+     * pixels of the circle: r*(1 - cos(a/2)) <= r*a*a/8 = tolerance */
+    unsigned int n = NK_CIRCLE_SEGMENTS_MIN;
+    if (radius > tolerance)
+        n = (unsigned int)(NK_PI * nk_sqrt(radius / (2.0f * tolerance))) + 1;
+    n = NK_CLAMP(NK_CIRCLE_SEGMENTS_MIN, n, NK_CIRCLE_SEGMENTS_MAX);
+    if (n <= table) {
+        /* round up to a multiple of four dividing the unit circle table
+         * so circles and rounded corners can take vertices from it */
+        while ((table % n) || (n & 3)) n++;
+    }
+    return n;
+}
+
+NK_INTERN unsigned int
+nk_draw_list_circle_segments(struct nk_draw_list *list, float radius)
+{
+    /* circle segment counts are cached for each integer radius */
+    const unsigned int table = (unsigned int)NK_LEN(list->circle_vtx);
+    int r = (int)radius;
+    if (list->circle_tolerance != list->curve_tolerance) {
+        nk_size i;
+        for (i = 0; i < NK_LEN(list->circle_segments); ++i)
+            list->circle_segments[i] = (nk_ushort)nk_draw_list_calc_segments(
+                (float)(i + 1), list->curve_tolerance, table);
+        list->circle_tolerance = list->curve_tolerance;
+    }
+    if (r >= 0 && r < (int)NK_LEN(list->circle_segments))
+        return list->circle_segments[r];
+    return nk_draw_list_calc_segments(radius, list->curve_tolerance, table);
+}
+
+NK_INTERN void
+nk_draw_list_path_arc_to_table(struct nk_draw_list *list, struct nk_vec2 center,
+    float radius, int a_min, int a_max, int step)
+{
+    /* arc between two entries of the unit circle table */
     if (a_min <= a_max) {
         int a = 0;
-        for (a = a_min; a <= a_max; a++) {
+        for (a = a_min; a <= a_max; a += step) {
             const struct nk_vec2 c = list->circle_vtx[(nk_size)a % NK_LEN(list->circle_vtx)];
             const float x = center.x + c.x * radius;
             const float y = center.y + c.y * radius;
@@ -6104,6 +7349,51 @@ nk_draw_list_path_arc_to_fast(struct nk_draw_list *list, struct nk_vec2 center,
     }
 }
 
+NK_API void
+nk_draw_list_path_arc_to_fast(struct nk_draw_list *list, struct nk_vec2 center,
+    float radius, int a_min, int a_max)
+{
+    /* `a_min` and `a_max` are given in twelfths of a circle */
+    const int step = (int)NK_LEN(list->circle_vtx) / 12;
+    NK_ASSERT(list);
+    if (!list) return;
+    nk_draw_list_path_arc_to_table(list, center, radius, a_min * step, a_max * step, step);
+}
+
+NK_INTERN void
+nk_draw_list_path_circle(struct nk_draw_list *list, struct nk_vec2 center,
+    float radius)
+{
+    /* closed circle with as many segments as needed for the list tolerance */
+    const unsigned int table = (unsigned int)NK_LEN(list->circle_vtx);
+    unsigned int n = nk_draw_list_circle_segments(list, radius);
+    if (n <= table) {
+        int step = (int)(table / n);
+        nk_draw_list_path_arc_to_table(list, center, radius, 0, (int)table - step, step);
+    } else {
+        unsigned int i;
+        for (i = 0; i < n; ++i) {
+            const float a = ((float)i / (float)n) * 2.0f * NK_PI;
+            const float x = center.x + (float)NK_COS(a) * radius;
+            const float y = center.y + (float)NK_SIN(a) * radius;
+            nk_draw_list_path_line_to(list, nk_vec2(x, y));
+        }
+    }
+}
+
+NK_INTERN unsigned int
+nk_draw_list_arc_segments(struct nk_draw_list *list, float radius,
+    float a_min, float a_max, unsigned int segments)
+{
+    if (list->curve_tolerance > 0.0f) {
+        /* share of the circle segments for the arc angle */
+        float turns = NK_ABS(a_max - a_min) / (2.0f * NK_PI);
+        float n = (float)nk_draw_list_circle_segments(list, radius) * turns;
+        segments = NK_CLAMP(1, (unsigned int)n + 1, NK_CIRCLE_SEGMENTS_MAX);
+    }
+    return segments;
+}
+
 NK_API void
 nk_draw_list_path_arc_to(struct nk_draw_list *list, struct nk_vec2 center,
     float radius, float a_min, float a_max, unsigned int segments)
@@ -6112,6 +7402,7 @@ nk_draw_list_path_arc_to(struct nk_draw_list *list, struct nk_vec2 center,
     NK_ASSERT(list);
     if (!list) return;
     if (radius == 0.0f) return;
+    segments = nk_draw_list_arc_segments(list, radius, a_min, a_max, segments);
     for (i = 0; i <= segments; ++i) {
         const float a = a_min + ((float)i / ((float)segments) * (a_max - a_min));
         const float x = center.x + (float)NK_COS(a) * radius;
@@ -6136,6 +7427,23 @@ nk_draw_list_path_rect_to(struct nk_draw_list *list, struct nk_vec2 a,
         nk_draw_list_path_line_to(list, nk_vec2(b.x,a.y));
         nk_draw_list_path_line_to(list, b);
         nk_draw_list_path_line_to(list, nk_vec2(a.x,b.y));
+    } else if (list->curve_tolerance > 0.0f) {
+        /* corners with as many segments as their radius needs */
+        const int table = (int)NK_LEN(list->circle_vtx);
+        const int q = table / 4;
+        int n = (int)nk_draw_list_circle_segments(list, r);
+        if (n <= table) {
+            int step = table / n;
+            nk_draw_list_path_arc_to_table(list, nk_vec2(a.x + r, a.y + r), r, 2*q, 3*q, step);
+            nk_draw_list_path_arc_to_table(list, nk_vec2(b.x - r, a.y + r), r, 3*q, 4*q, step);
+            nk_draw_list_path_arc_to_table(list, nk_vec2(b.x - r, b.y - r), r, 0, q, step);
+            nk_draw_list_path_arc_to_table(list, nk_vec2(a.x + r, b.y - r), r, q, 2*q, step);
+        } else {
+            nk_draw_list_path_arc_to(list, nk_vec2(a.x + r, a.y + r), r, NK_PI, 1.5f*NK_PI, 0);
+            nk_draw_list_path_arc_to(list, nk_vec2(b.x - r, a.y + r), r, 1.5f*NK_PI, 2.0f*NK_PI, 0);
+            nk_draw_list_path_arc_to(list, nk_vec2(b.x - r, b.y - r), r, 0.0f, 0.5f*NK_PI, 0);
+            nk_draw_list_path_arc_to(list, nk_vec2(a.x + r, b.y - r), r, 0.5f*NK_PI, NK_PI, 0);
+        }
     } else {
         nk_draw_list_path_arc_to_fast(list, nk_vec2(a.x + r, a.y + r), r, 6, 9);
         nk_draw_list_path_arc_to_fast(list, nk_vec2(b.x - r, a.y + r), r, 9, 12);
@@ -6144,6 +7452,26 @@ nk_draw_list_path_rect_to(struct nk_draw_list *list, struct nk_vec2 a,
     }
 }
 
+NK_INTERN unsigned int
+nk_draw_list_curve_segments(struct nk_draw_list *list, struct nk_vec2 p1,
+    struct nk_vec2 p2, struct nk_vec2 p3, struct nk_vec2 p4,
+    unsigned int num_segments)
+{
+    if (list->curve_tolerance > 0.0f) {
+        /* Wang's formula: uniform segments needed to keep the curve within
+         * tolerance from its second differences */
+        struct nk_vec2 d0, d1;
+        float d;
+        d0 = nk_vec2(p1.x - 2*p2.x + p3.x, p1.y - 2*p2.y + p3.y);
+        d1 = nk_vec2(p2.x - 2*p3.x + p4.x, p2.y - 2*p3.y + p4.y);
+        d = NK_MAX(nk_vec2_len_sqr(d0), nk_vec2_len_sqr(d1));
+        d = (d > 0.0f) ? nk_sqrt(d): 0.0f;
+        num_segments = (unsigned int)nk_sqrt(0.75f * d / list->curve_tolerance) + 1;
+        num_segments = NK_MIN(num_segments, NK_CIRCLE_SEGMENTS_MAX);
+    }
+    return NK_MAX(num_segments, 1);
+}
+
 NK_API void
 nk_draw_list_path_curve_to(struct nk_draw_list *list, struct nk_vec2 p2,
     struct nk_vec2 p3, struct nk_vec2 p4, unsigned int num_segments)
@@ -6155,9 +7483,9 @@ nk_draw_list_path_curve_to(struct nk_draw_list *list, struct nk_vec2 p2,
     NK_ASSERT(list);
     NK_ASSERT(list->path_count);
     if (!list || !list->path_count) return;
-    num_segments = NK_MAX(num_segments, 1);
 
     p1 = nk_draw_list_path_last(list);
+    num_segments = nk_draw_list_curve_segments(list, p1, p2, p3, p4, num_segments);
     t_step = 1.0f/(float)num_segments;
     for (i_step = 1; i_step <= num_segments; ++i_step) {
         float t = t_step * (float)i_step;
@@ -6213,6 +7541,11 @@ nk_draw_list_fill_rect(struct nk_draw_list *list, struct nk_rect rect,
 {
     NK_ASSERT(list);
     if (!list || !col.a) return;
+    if (list->instances && nk_draw_list_rect_instance(list, rect, col, rounding, 0.0f))
+        return;
+    if (rounding == 0.0f && nk_draw_list_fill_rect_fast(list, nk_vec2(rect.x + 0.5f,
+        rect.y + 0.5f), nk_vec2(rect.x + rect.w + 0.5f, rect.y + rect.h + 0.5f), col))
+        return;
     nk_draw_list_path_rect_to(list, nk_vec2(rect.x + 0.5f, rect.y + 0.5f),
         nk_vec2(rect.x + rect.w + 0.5f, rect.y + rect.h + 0.5f), rounding);
     nk_draw_list_path_fill(list,  col);
@@ -6224,6 +7557,12 @@ nk_draw_list_stroke_rect(struct nk_draw_list *list, struct nk_rect rect,
 {
     NK_ASSERT(list);
     if (!list || !col.a) return;
+    if (list->instances && thickness > 0.0f &&
+        nk_draw_list_rect_instance(list, rect, col, rounding, thickness))
+        return;
+    if (rounding == 0.0f && nk_draw_list_stroke_rect_fast(list, nk_vec2(rect.x + 0.5f,
+        rect.y + 0.5f), nk_vec2(rect.x + rect.w + 0.5f, rect.y + rect.h + 0.5f), col, thickness))
+        return;
     nk_draw_list_path_rect_to(list, nk_vec2(rect.x + 0.5f, rect.y + 0.5f),
         nk_vec2(rect.x + rect.w + 0.5f, rect.y + rect.h + 0.5f), rounding);
     nk_draw_list_path_stroke(list,  col, NK_STROKE_CLOSED, thickness);
@@ -6239,26 +7578,24 @@ nk_draw_list_fill_rect_multi_color(struct nk_draw_list *list, struct nk_rect rec
     nk_draw_vertex_color col_right = nk_color_u32(right);
     nk_draw_vertex_color col_bottom = nk_color_u32(bottom);
 
-    struct nk_draw_vertex *vtx;
-    nk_draw_index *idx;
-    nk_draw_index index;
+    void *vtx;
+    void *idx;
+    nk_size index;
     NK_ASSERT(list);
     if (!list) return;
 
     nk_draw_list_push_image(list, list->null.texture);
-    index = (nk_draw_index)list->vertex_count;
+    index = nk_draw_list_vertex_index(list, 4);
     vtx = nk_draw_list_alloc_vertices(list, 4);
     idx = nk_draw_list_alloc_elements(list, 6);
     if (!vtx || !idx) return;
 
-    idx[0] = (nk_draw_index)(index+0); idx[1] = (nk_draw_index)(index+1);
-    idx[2] = (nk_draw_index)(index+2); idx[3] = (nk_draw_index)(index+0);
-    idx[4] = (nk_draw_index)(index+2); idx[5] = (nk_draw_index)(index+3);
+    nk_draw_list_push_indices(list, idx, index, nk_draw_quad_indices, 6);
 
-    vtx[0] = nk_draw_vertex(nk_vec2(rect.x, rect.y), list->null.uv, col_left);
-    vtx[1] = nk_draw_vertex(nk_vec2(rect.x + rect.w, rect.y), list->null.uv, col_top);
-    vtx[2] = nk_draw_vertex(nk_vec2(rect.x + rect.w, rect.y + rect.h), list->null.uv, col_right);
-    vtx[3] = nk_draw_vertex(nk_vec2(rect.x, rect.y + rect.h), list->null.uv, col_bottom);
+    vtx = nk_draw_vertex(vtx, list, nk_vec2(rect.x, rect.y), list->null.uv, col_left);
+    vtx = nk_draw_vertex(vtx, list, nk_vec2(rect.x + rect.w, rect.y), list->null.uv, col_top);
+    vtx = nk_draw_vertex(vtx, list, nk_vec2(rect.x + rect.w, rect.y + rect.h), list->null.uv, col_right);
+    vtx = nk_draw_vertex(vtx, list, nk_vec2(rect.x, rect.y + rect.h), list->null.uv, col_bottom);
 }
 
 NK_API void
@@ -6292,6 +7629,11 @@ nk_draw_list_fill_circle(struct nk_draw_list *list, struct nk_vec2 center,
     float a_max;
     NK_ASSERT(list);
     if (!list || !col.a) return;
+    if (list->curve_tolerance > 0.0f) {
+        nk_draw_list_path_circle(list, center, radius);
+        nk_draw_list_path_fill(list, col);
+        return;
+    }
     a_max = NK_PI * 2.0f * ((float)segs - 1.0f) / (float)segs;
     nk_draw_list_path_arc_to(list, center, radius, 0.0f, a_max, segs);
     nk_draw_list_path_fill(list, col);
@@ -6304,6 +7646,11 @@ nk_draw_list_stroke_circle(struct nk_draw_list *list, struct nk_vec2 center,
     float a_max;
     NK_ASSERT(list);
     if (!list || !col.a) return;
+    if (list->curve_tolerance > 0.0f) {
+        nk_draw_list_path_circle(list, center, radius);
+        nk_draw_list_path_stroke(list, col, NK_STROKE_CLOSED, thickness);
+        return;
+    }
     a_max = NK_PI * 2.0f * ((float)segs - 1.0f) / (float)segs;
     nk_draw_list_path_arc_to(list, center, radius, 0.0f, a_max, segs);
     nk_draw_list_path_stroke(list, col, NK_STROKE_CLOSED, thickness);
@@ -6327,34 +7674,45 @@ nk_draw_list_push_rect_uv(struct nk_draw_list *list, struct nk_vec2 a,
     struct nk_color color)
 {
     nk_draw_vertex_color col = nk_color_u32(color);
-    struct nk_draw_vertex *vtx;
+    void *vtx;
     struct nk_vec2 uvb;
     struct nk_vec2 uvd;
     struct nk_vec2 b;
     struct nk_vec2 d;
-    nk_draw_index *idx;
-    nk_draw_index index;
+    void *idx;
+    nk_size index;
     NK_ASSERT(list);
     if (!list) return;
+    if (list->instances) {
+        struct nk_draw_instance *inst = nk_draw_list_alloc_instance(list);
+        if (!inst) return;
+        inst->x = a.x; inst->y = a.y;
+        inst->w = c.x - a.x; inst->h = c.y - a.y;
+        inst->uv[0] = uva.x; inst->uv[1] = uva.y;
+        inst->uv[2] = uvc.x; inst->uv[3] = uvc.y;
+        inst->col = col;
+        inst->rounding = 0.0f;
+        inst->thickness = 0.0f;
+        inst->type = NK_DRAW_INSTANCE_QUAD;
+        return;
+    }
 
     uvb = nk_vec2(uvc.x, uva.y);
     uvd = nk_vec2(uva.x, uvc.y);
     b = nk_vec2(c.x, a.y);
     d = nk_vec2(a.x, c.y);
 
-    index = (nk_draw_index)list->vertex_count;
+    index = nk_draw_list_vertex_index(list, 4);
     vtx = nk_draw_list_alloc_vertices(list, 4);
     idx = nk_draw_list_alloc_elements(list, 6);
     if (!vtx || !idx) return;
 
-    idx[0] = (nk_draw_index)(index+0); idx[1] = (nk_draw_index)(index+1);
-    idx[2] = (nk_draw_index)(index+2); idx[3] = (nk_draw_index)(index+0);
-    idx[4] = (nk_draw_index)(index+2); idx[5] = (nk_draw_index)(index+3);
+    nk_draw_list_push_indices(list, idx, index, nk_draw_quad_indices, 6);
 
-    vtx[0] = nk_draw_vertex(a, uva, col);
-    vtx[1] = nk_draw_vertex(b, uvb, col);
-    vtx[2] = nk_draw_vertex(c, uvc, col);
-    vtx[3] = nk_draw_vertex(d, uvd, col);
+    vtx = nk_draw_vertex(vtx, list, a, uva, col);
+    vtx = nk_draw_vertex(vtx, list, b, uvb, col);
+    vtx = nk_draw_vertex(vtx, list, c, uvc, col);
+    vtx = nk_draw_vertex(vtx, list, d, uvd, col);
 }
 
 NK_API void
@@ -6391,6 +7749,7 @@ nk_draw_list_add_text(struct nk_draw_list *list, const struct nk_user_font *font
     int glyph_len = 0;
     int next_glyph_len = 0;
     struct nk_user_font_glyph g;
+    nk_handle texture;
 
     NK_ASSERT(list);
     if (!list || !len || !text) return;
@@ -6399,7 +7758,8 @@ nk_draw_list_add_text(struct nk_draw_list *list, const struct nk_user_font *font
         rect.x < list->clip_rect.x || rect.y < list->clip_rect.y)
         return;
 
-    nk_draw_list_push_image(list, font->texture);
+    texture = font->texture;
+    nk_draw_list_push_image(list, texture);
     x = rect.x;
     glyph_len = text_len = nk_utf_decode(text, &unicode, len);
     if (!glyph_len) return;
@@ -6411,10 +7771,18 @@ nk_draw_list_add_text(struct nk_draw_list *list, const struct nk_user_font *font
         if (unicode == NK_UTF_INVALID) break;
 
         /* query currently drawn glyph information */
+        next = 0;
         next_glyph_len = nk_utf_decode(text + text_len, &next, (int)len - text_len);
+        g.texture = font->texture;
         font->query(font->userdata, font_height, &g, unicode,
                     (next == NK_UTF_INVALID) ? '\0' : next);
 
+        /* glyphs of multi page fonts can live on another texture */
+        if (g.texture.id != texture.id) {
+            texture = g.texture;
+            nk_draw_list_push_image(list, texture);
+        }
+
         /* calculate and draw glyph drawing rectangle and image */
         gx = x + g.offset.x;
         /*gy = rect.y + (rect.h/2) - (font->height/2) + g.offset.y;*/
@@ -6426,13 +7794,149 @@ nk_draw_list_add_text(struct nk_draw_list *list, const struct nk_user_font *font
             g.uv[0], g.uv[1], fg);
 
         /* offset next glyph */
+        glyph_len = next_glyph_len;
         text_len += glyph_len;
         x += char_width;
-        glyph_len = next_glyph_len;
         unicode = next;
     }
 }
 
+NK_INTERN void
+nk_convert_setup(struct nk_draw_list *list, const struct nk_convert_config *config,
+    struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements)
+{
+    nk_draw_list_setup(list, config->global_alpha, config->line_AA,
+        config->shape_AA, config->null, cmds, vertices, elements);
+    if (config->index_type != NK_INDEX_DEFAULT)
+        list->index_type = config->index_type;
+    list->curve_tolerance = NK_MAX(config->curve_tolerance, 0.0f);
+    if (config->vertex_layout) {
+        NK_ASSERT(config->vertex_size && config->vertex_alignment);
+        NK_ASSERT((config->vertex_size % config->vertex_alignment) == 0);
+        list->vertex_layout = config->vertex_layout;
+        list->vertex_size = config->vertex_size;
+        list->vertex_alignment = config->vertex_alignment;
+    }
+}
+
+NK_INTERN void
+nk_convert_command(struct nk_draw_list *list, const struct nk_command *cmd,
+    const struct nk_convert_config *config)
+{
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    list->userdata = cmd->userdata;
+#endif
+    switch (cmd->type) {
+    case NK_COMMAND_NOP: break;
+    case NK_COMMAND_SCISSOR: {
+        const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
+        nk_draw_list_add_clip(list, nk_rect(s->x, s->y, s->w, s->h));
+    } break;
+    case NK_COMMAND_LINE: {
+        const struct nk_command_line *l = (const struct nk_command_line*)cmd;
+        nk_draw_list_stroke_line(list, nk_vec2(l->begin.x, l->begin.y),
+            nk_vec2(l->end.x, l->end.y), l->color, l->line_thickness);
+    } break;
+    case NK_COMMAND_CURVE: {
+        const struct nk_command_curve *q = (const struct nk_command_curve*)cmd;
+        nk_draw_list_stroke_curve(list, nk_vec2(q->begin.x, q->begin.y),
+            nk_vec2(q->ctrl[0].x, q->ctrl[0].y), nk_vec2(q->ctrl[1].x,
+            q->ctrl[1].y), nk_vec2(q->end.x, q->end.y), q->color,
+            config->curve_segment_count, q->line_thickness);
+    } break;
+    case NK_COMMAND_RECT: {
+        const struct nk_command_rect *r = (const struct nk_command_rect*)cmd;
+        nk_draw_list_stroke_rect(list, nk_rect(r->x, r->y, r->w, r->h),
+            r->color, (float)r->rounding, r->line_thickness);
+    } break;
+    case NK_COMMAND_RECT_FILLED: {
+        const struct nk_command_rect_filled *r = (const struct nk_command_rect_filled*)cmd;
+        nk_draw_list_fill_rect(list, nk_rect(r->x, r->y, r->w, r->h),
+            r->color, (float)r->rounding);
+    } break;
+    case NK_COMMAND_RECT_MULTI_COLOR: {
+        const struct nk_command_rect_multi_color *r = (const struct nk_command_rect_multi_color*)cmd;
+        nk_draw_list_fill_rect_multi_color(list, nk_rect(r->x, r->y, r->w, r->h),
+            r->left, r->top, r->right, r->bottom);
+    } break;
+    case NK_COMMAND_CIRCLE: {
+        const struct nk_command_circle *c = (const struct nk_command_circle*)cmd;
+        nk_draw_list_stroke_circle(list, nk_vec2((float)c->x + (float)c->w/2,
+            (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
+            config->circle_segment_count, c->line_thickness);
+    } break;
+    case NK_COMMAND_CIRCLE_FILLED: {
+        const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled *)cmd;
+        nk_draw_list_fill_circle(list, nk_vec2((float)c->x + (float)c->w/2,
+            (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
+            config->circle_segment_count);
+    } break;
+    case NK_COMMAND_ARC: {
+        const struct nk_command_arc *c = (const struct nk_command_arc*)cmd;
+        nk_draw_list_path_line_to(list, nk_vec2(c->cx, c->cy));
+        nk_draw_list_path_arc_to(list, nk_vec2(c->cx, c->cy), c->r,
+            c->a[0], c->a[1], config->arc_segment_count);
+        nk_draw_list_path_stroke(list, c->color, NK_STROKE_CLOSED, c->line_thickness);
+    } break;
+    case NK_COMMAND_ARC_FILLED: {
+        const struct nk_command_arc_filled *c = (const struct nk_command_arc_filled*)cmd;
+        nk_draw_list_path_line_to(list, nk_vec2(c->cx, c->cy));
+        nk_draw_list_path_arc_to(list, nk_vec2(c->cx, c->cy), c->r,
+            c->a[0], c->a[1], config->arc_segment_count);
+        nk_draw_list_path_fill(list, c->color);
+    } break;
+    case NK_COMMAND_TRIANGLE: {
+        const struct nk_command_triangle *t = (const struct nk_command_triangle*)cmd;
+        nk_draw_list_stroke_triangle(list, nk_vec2(t->a.x, t->a.y),
+            nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color,
+            t->line_thickness);
+    } break;
+    case NK_COMMAND_TRIANGLE_FILLED: {
+        const struct nk_command_triangle_filled *t = (const struct nk_command_triangle_filled*)cmd;
+        nk_draw_list_fill_triangle(list, nk_vec2(t->a.x, t->a.y),
+            nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color);
+    } break;
+    case NK_COMMAND_POLYGON: {
+        int i;
+        const struct nk_command_polygon*p = (const struct nk_command_polygon*)cmd;
+        for (i = 0; i < p->point_count; ++i) {
+            struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
+            nk_draw_list_path_line_to(list, pnt);
+        }
+        nk_draw_list_path_stroke(list, p->color, NK_STROKE_CLOSED, p->line_thickness);
+    } break;
+    case NK_COMMAND_POLYGON_FILLED: {
+        int i;
+        const struct nk_command_polygon_filled *p = (const struct nk_command_polygon_filled*)cmd;
+        for (i = 0; i < p->point_count; ++i) {
+            struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
+            nk_draw_list_path_line_to(list, pnt);
+        }
+        nk_draw_list_path_fill(list, p->color);
+    } break;
+    case NK_COMMAND_POLYLINE: {
+        int i;
+        const struct nk_command_polyline *p = (const struct nk_command_polyline*)cmd;
+        for (i = 0; i < p->point_count; ++i) {
+            struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
+            nk_draw_list_path_line_to(list, pnt);
+        }
+        nk_draw_list_path_stroke(list, p->color, NK_STROKE_OPEN, p->line_thickness);
+    } break;
+    case NK_COMMAND_TEXT: {
+        const struct nk_command_text *t = (const struct nk_command_text*)cmd;
+        nk_draw_list_add_text(list, t->font, nk_rect(t->x, t->y, t->w, t->h),
+            t->string, t->length, t->height, t->foreground);
+    } break;
+    case NK_COMMAND_IMAGE: {
+        const struct nk_command_image *i = (const struct nk_command_image*)cmd;
+        nk_draw_list_add_image(list, i->img, nk_rect(i->x, i->y, i->w, i->h),
+            nk_rgb(255, 255, 255));
+    } break;
+    default: break;
+    }
+}
+
 NK_API void
 nk_convert(struct nk_context *ctx, struct nk_buffer *cmds,
     struct nk_buffer *vertices, struct nk_buffer *elements,
@@ -6446,123 +7950,769 @@ nk_convert(struct nk_context *ctx, struct nk_buffer *cmds,
     if (!ctx || !cmds || !vertices || !elements)
         return;
 
-    nk_draw_list_setup(&ctx->draw_list, config->global_alpha, config->line_AA,
-        config->shape_AA, config->null, cmds, vertices, elements);
+    nk_convert_setup(&ctx->draw_list, config, cmds, vertices, elements);
     nk_foreach(cmd, ctx)
-    {
-#ifdef NK_INCLUDE_COMMAND_USERDATA
-        list->userdata = cmd->userdata;
-#endif
-        switch (cmd->type) {
-        case NK_COMMAND_NOP: break;
-        case NK_COMMAND_SCISSOR: {
-            const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
-            nk_draw_list_add_clip(&ctx->draw_list, nk_rect(s->x, s->y, s->w, s->h));
-        } break;
-        case NK_COMMAND_LINE: {
-            const struct nk_command_line *l = (const struct nk_command_line*)cmd;
-            nk_draw_list_stroke_line(&ctx->draw_list, nk_vec2(l->begin.x, l->begin.y),
-                nk_vec2(l->end.x, l->end.y), l->color, l->line_thickness);
-        } break;
-        case NK_COMMAND_CURVE: {
-            const struct nk_command_curve *q = (const struct nk_command_curve*)cmd;
-            nk_draw_list_stroke_curve(&ctx->draw_list, nk_vec2(q->begin.x, q->begin.y),
-                nk_vec2(q->ctrl[0].x, q->ctrl[0].y), nk_vec2(q->ctrl[1].x,
-                q->ctrl[1].y), nk_vec2(q->end.x, q->end.y), q->color,
-                config->curve_segment_count, q->line_thickness);
-        } break;
-        case NK_COMMAND_RECT: {
-            const struct nk_command_rect *r = (const struct nk_command_rect*)cmd;
-            nk_draw_list_stroke_rect(&ctx->draw_list, nk_rect(r->x, r->y, r->w, r->h),
-                r->color, (float)r->rounding, r->line_thickness);
-        } break;
-        case NK_COMMAND_RECT_FILLED: {
-            const struct nk_command_rect_filled *r = (const struct nk_command_rect_filled*)cmd;
-            nk_draw_list_fill_rect(&ctx->draw_list, nk_rect(r->x, r->y, r->w, r->h),
-                r->color, (float)r->rounding);
-        } break;
-        case NK_COMMAND_RECT_MULTI_COLOR: {
-            const struct nk_command_rect_multi_color *r = (const struct nk_command_rect_multi_color*)cmd;
-            nk_draw_list_fill_rect_multi_color(&ctx->draw_list, nk_rect(r->x, r->y, r->w, r->h),
-                r->left, r->top, r->right, r->bottom);
-        } break;
-        case NK_COMMAND_CIRCLE: {
-            const struct nk_command_circle *c = (const struct nk_command_circle*)cmd;
-            nk_draw_list_stroke_circle(&ctx->draw_list, nk_vec2((float)c->x + (float)c->w/2,
-                (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
-                config->circle_segment_count, c->line_thickness);
-        } break;
-        case NK_COMMAND_CIRCLE_FILLED: {
-            const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled *)cmd;
-            nk_draw_list_fill_circle(&ctx->draw_list, nk_vec2((float)c->x + (float)c->w/2,
-                (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
-                config->circle_segment_count);
-        } break;
-        case NK_COMMAND_ARC: {
-            const struct nk_command_arc *c = (const struct nk_command_arc*)cmd;
-            nk_draw_list_path_line_to(&ctx->draw_list, nk_vec2(c->cx, c->cy));
-            nk_draw_list_path_arc_to(&ctx->draw_list, nk_vec2(c->cx, c->cy), c->r,
-                c->a[0], c->a[1], config->arc_segment_count);
-            nk_draw_list_path_stroke(&ctx->draw_list, c->color, NK_STROKE_CLOSED, c->line_thickness);
-        } break;
-        case NK_COMMAND_ARC_FILLED: {
-            const struct nk_command_arc_filled *c = (const struct nk_command_arc_filled*)cmd;
-            nk_draw_list_path_line_to(&ctx->draw_list, nk_vec2(c->cx, c->cy));
-            nk_draw_list_path_arc_to(&ctx->draw_list, nk_vec2(c->cx, c->cy), c->r,
-                c->a[0], c->a[1], config->arc_segment_count);
-            nk_draw_list_path_fill(&ctx->draw_list, c->color);
-        } break;
-        case NK_COMMAND_TRIANGLE: {
-            const struct nk_command_triangle *t = (const struct nk_command_triangle*)cmd;
-            nk_draw_list_stroke_triangle(&ctx->draw_list, nk_vec2(t->a.x, t->a.y),
-                nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color,
-                t->line_thickness);
-        } break;
-        case NK_COMMAND_TRIANGLE_FILLED: {
-            const struct nk_command_triangle_filled *t = (const struct nk_command_triangle_filled*)cmd;
-            nk_draw_list_fill_triangle(&ctx->draw_list, nk_vec2(t->a.x, t->a.y),
-                nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color);
-        } break;
-        case NK_COMMAND_POLYGON: {
-            int i;
-            const struct nk_command_polygon*p = (const struct nk_command_polygon*)cmd;
-            for (i = 0; i < p->point_count; ++i) {
-                struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
-                nk_draw_list_path_line_to(&ctx->draw_list, pnt);
-            }
-            nk_draw_list_path_stroke(&ctx->draw_list, p->color, NK_STROKE_CLOSED, p->line_thickness);
-        } break;
-        case NK_COMMAND_POLYGON_FILLED: {
-            int i;
-            const struct nk_command_polygon_filled *p = (const struct nk_command_polygon_filled*)cmd;
-            for (i = 0; i < p->point_count; ++i) {
-                struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
-                nk_draw_list_path_line_to(&ctx->draw_list, pnt);
+        nk_convert_command(&ctx->draw_list, cmd, config);
+}
+
+NK_API void
+nk_convert_instanced(struct nk_context *ctx, struct nk_buffer *cmds,
+    struct nk_buffer *vertices, struct nk_buffer *elements,
+    struct nk_buffer *instances, const struct nk_convert_config *config)
+{
+    const struct nk_command *cmd;
+    NK_ASSERT(ctx);
+    NK_ASSERT(cmds);
+    NK_ASSERT(vertices);
+    NK_ASSERT(elements);
+    NK_ASSERT(instances);
+    if (!ctx || !cmds || !vertices || !elements || !instances)
+        return;
+
+    nk_convert_setup(&ctx->draw_list, config, cmds, vertices, elements);
+    ctx->draw_list.instances = instances;
+    nk_foreach(cmd, ctx)
+        nk_convert_command(&ctx->draw_list, cmd, config);
+}
+
+NK_API void
+nk_convert_job_run(struct nk_convert_job *job)
+{
+    const struct nk_command *cmd;
+    unsigned int i;
+    NK_ASSERT(job);
+    if (!job) return;
+
+    nk_draw_list_init(&job->list);
+    nk_convert_setup(&job->list, job->config, &job->cmds, &job->vertices, &job->elements);
+    if (job->continued)
+        nk_draw_list_push_command(&job->list, job->clip, job->config->null.texture);
+
+    cmd = nk_ptr_add_const(struct nk_command, job->memory, job->begin);
+    for (i = 0; i < job->count; ++i) {
+        nk_convert_command(&job->list, cmd, job->config);
+        if (i + 1 < job->count)
+            cmd = nk_ptr_add_const(struct nk_command, job->memory, cmd->next);
+    }
+}
+
+NK_INTERN const struct nk_window*
+nk_convert_find_window(const struct nk_context *ctx, nk_size offset)
+{
+    /* returns the window whose command memory contains `offset` */
+    const struct nk_window *iter = ctx->begin;
+    while (iter && (offset < iter->buffer.begin || offset >= iter->buffer.end))
+        iter = iter->next;
+    return iter;
+}
+
+NK_INTERN void
+nk_convert_merge(struct nk_draw_list *list, struct nk_convert_job *job,
+    void *vertices, void *elements)
+{
+    /* copies the job output into already allocated vertex and element memory,
+     * appends its draw commands and rebases all element indices */
+    const struct nk_draw_command *first;
+    const struct nk_draw_command *src;
+    struct nk_draw_command *dst;
+    int split = (list->index_type == NK_INDEX_16BIT_SPLIT);
+    nk_size vertex_base = list->vertex_count;
+    nk_size count = job->list.element_count;
+    nk_size i;
+
+    if (job->list.vertex_count)
+        NK_MEMCPY(vertices, nk_buffer_memory_const(&job->vertices),
+            job->list.vertex_count * list->vertex_size);
+    if (list->index_type == NK_INDEX_32BIT) {
+        const nk_uint *ids = (const nk_uint*)nk_buffer_memory_const(&job->elements);
+        nk_uint *out = (nk_uint*)elements;
+        for (i = 0; i < count; ++i)
+            out[i] = (nk_uint)(ids[i] + vertex_base);
+    } else {
+        const nk_ushort *ids = (const nk_ushort*)nk_buffer_memory_const(&job->elements);
+        nk_ushort *out = (nk_ushort*)elements;
+        nk_size base = (split) ? 0: vertex_base;
+        for (i = 0; i < count; ++i)
+            out[i] = (nk_ushort)(ids[i] + base);
+    }
+
+    first = nk__draw_list_begin(&job->list, &job->cmds);
+    nk_draw_list_foreach(src, &job->list, &job->cmds) {
+        if (!src->elem_count) continue;
+        if (src == first && job->continued) {
+            /* the first command continues the state of the previous job */
+            dst = (list->cmd_count) ? nk_draw_list_command_last(list): 0;
+            if (dst && !split && dst->texture.id == src->texture.id &&
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+                dst->userdata.id == src->userdata.id &&
+#endif
+                dst->clip_rect.x == src->clip_rect.x && dst->clip_rect.y == src->clip_rect.y &&
+                dst->clip_rect.w == src->clip_rect.w && dst->clip_rect.h == src->clip_rect.h) {
+                dst->elem_count += src->elem_count;
+                continue;
             }
-            nk_draw_list_path_fill(&ctx->draw_list, p->color);
-        } break;
-        case NK_COMMAND_POLYLINE: {
-            int i;
-            const struct nk_command_polyline *p = (const struct nk_command_polyline*)cmd;
-            for (i = 0; i < p->point_count; ++i) {
-                struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
-                nk_draw_list_path_line_to(&ctx->draw_list, pnt);
+        }
+        dst = nk_draw_list_push_command(list, src->clip_rect, src->texture);
+        if (!dst) break;
+        dst->elem_count = src->elem_count;
+        dst->vertex_offset = (split) ? src->vertex_offset + (unsigned int)vertex_base: 0;
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+        dst->userdata = src->userdata;
+#endif
+    }
+    list->vertex_count += job->list.vertex_count;
+    list->element_count += job->list.element_count;
+}
+
+#ifdef NK_INCLUDE_FONT_BAKING
+NK_INTERN void nk_font_query_font_glyph(nk_handle, float, struct nk_user_font_glyph*,
+    nk_rune, nk_rune);
+#endif
+
+NK_INTERN int
+nk_convert_is_thread_safe(const struct nk_command *cmd)
+{
+    /* glyph lookups in fonts with a dynamic cache modify the atlas. This
+     * includes the caches of all fonts in the fallback chain */
+#ifdef NK_INCLUDE_FONT_BAKING
+    const struct nk_command_text *t;
+    const struct nk_font *font;
+    int i;
+    if (cmd->type != NK_COMMAND_TEXT) return nk_true;
+    t = (const struct nk_command_text*)cmd;
+    if (!t->font || t->font->query != nk_font_query_font_glyph) return nk_true;
+    font = (const struct nk_font*)t->font->userdata.ptr;
+    if (!font) return nk_true;
+    if (font->cache) return nk_false;
+    for (i = 0; i < font->fallback_count; ++i)
+        if (font->fallbacks[i]->cache) return nk_false;
+    return nk_true;
+#else
+    NK_UNUSED(cmd);
+    return nk_true;
+#endif
+}
+
+NK_API void
+nk_convert_parallel(struct nk_context *ctx, struct nk_buffer *cmds,
+    struct nk_buffer *vertices, struct nk_buffer *elements,
+    const struct nk_convert_config *config,
+    const struct nk_convert_dispatcher *dispatcher)
+{
+    const struct nk_command *cmd;
+    const struct nk_window *win = 0;
+    struct nk_convert_job *jobs = 0;
+    struct nk_convert_job *job = 0;
+    struct nk_draw_list *list;
+    struct nk_rect clip = nk_null_rect;
+    unsigned int capacity = 0, job_count = 0, i;
+    nk_size vertex_total = 0, element_total = 0, element_size;
+    nk_byte *vtx = 0, *idx = 0;
+
+    NK_ASSERT(ctx);
+    NK_ASSERT(cmds);
+    NK_ASSERT(vertices);
+    NK_ASSERT(elements);
+    if (!ctx || !cmds || !vertices || !elements)
+        return;
+    if (!dispatcher || !dispatcher->dispatch || !dispatcher->alloc.alloc) {
+        nk_convert(ctx, cmds, vertices, elements, config);
+        return;
+    }
+
+    /* an upper bound for the number of jobs */
+    nk_foreach(cmd, ctx) {
+        if (!nk_convert_is_thread_safe(cmd)) {
+            nk_convert(ctx, cmds, vertices, elements, config);
+            return;
+        }
+        capacity++;
+    }
+    if (dispatcher->commands_per_job)
+        capacity = capacity / dispatcher->commands_per_job + 1;
+    else capacity = NK_MIN(capacity, ctx->count);
+
+    nk_convert_setup(&ctx->draw_list, config, cmds, vertices, elements);
+    list = &ctx->draw_list;
+    if (!capacity) return;
+    jobs = (struct nk_convert_job*)dispatcher->alloc.alloc(dispatcher->alloc.userdata,
+        0, sizeof(struct nk_convert_job) * capacity);
+    NK_ASSERT(jobs);
+    if (!jobs) return;
+    nk_zero(jobs, sizeof(struct nk_convert_job) * capacity);
+
+    /* split the command list into jobs */
+    nk_foreach(cmd, ctx) {
+        nk_size offset = (nk_size)((const nk_byte*)cmd -
+            (const nk_byte*)nk_buffer_memory_const(&ctx->memory));
+        int split = !job;
+        if (dispatcher->commands_per_job) {
+            if (job) split = (job->count >= dispatcher->commands_per_job);
+        } else if (!win || offset < win->buffer.begin || offset >= win->buffer.end) {
+            win = nk_convert_find_window(ctx, offset);
+            split = nk_true;
+        }
+
+        if (split && job_count >= capacity) {
+            /* a window can be split more than once, e.g. around its popups */
+            struct nk_convert_job *grown = (struct nk_convert_job*)
+                dispatcher->alloc.alloc(dispatcher->alloc.userdata, jobs,
+                    sizeof(struct nk_convert_job) * capacity * 2);
+            if (!grown) {
+                for (i = 0; i < capacity; ++i) {
+                    nk_buffer_free(&jobs[i].cmds);
+                    nk_buffer_free(&jobs[i].vertices);
+                    nk_buffer_free(&jobs[i].elements);
+                }
+                dispatcher->alloc.free(dispatcher->alloc.userdata, jobs);
+                nk_convert(ctx, cmds, vertices, elements, config);
+                return;
             }
-            nk_draw_list_path_stroke(&ctx->draw_list, p->color, NK_STROKE_OPEN, p->line_thickness);
-        } break;
-        case NK_COMMAND_TEXT: {
-            const struct nk_command_text *t = (const struct nk_command_text*)cmd;
-            nk_draw_list_add_text(&ctx->draw_list, t->font, nk_rect(t->x, t->y, t->w, t->h),
-                t->string, t->length, t->height, t->foreground);
-        } break;
-        case NK_COMMAND_IMAGE: {
-            const struct nk_command_image *i = (const struct nk_command_image*)cmd;
-            nk_draw_list_add_image(&ctx->draw_list, i->img, nk_rect(i->x, i->y, i->w, i->h),
-                nk_rgb(255, 255, 255));
-        } break;
-        default: break;
+            if (grown != jobs) {
+                NK_MEMCPY(grown, jobs, sizeof(struct nk_convert_job) * capacity);
+                dispatcher->alloc.free(dispatcher->alloc.userdata, jobs);
+            }
+            nk_zero(grown + capacity, sizeof(struct nk_convert_job) * capacity);
+            jobs = grown;
+            capacity *= 2;
+        }
+        if (split) {
+            job = &jobs[job_count];
+            job->memory = nk_buffer_memory_const(&ctx->memory);
+            job->begin = offset;
+            job->config = config;
+            job->clip = clip;
+            job->continued = (job_count != 0);
+            nk_buffer_init(&job->cmds, &dispatcher->alloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+            nk_buffer_init(&job->vertices, &dispatcher->alloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+            nk_buffer_init(&job->elements, &dispatcher->alloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+            job_count++;
+        }
+        if (cmd->type == NK_COMMAND_SCISSOR) {
+            const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
+            clip = nk_rect(s->x, s->y, s->w, s->h);
+        }
+        job->count++;
+    }
+    dispatcher->dispatch(dispatcher->userdata, jobs, (int)job_count);
+
+    /* concatenate all job buffers into the output buffers */
+    for (i = 0; i < job_count; ++i) {
+        vertex_total += jobs[i].list.vertex_count;
+        element_total += jobs[i].list.element_count;
+    }
+    element_size = (list->index_type == NK_INDEX_32BIT) ? sizeof(nk_uint): sizeof(nk_ushort);
+    if (vertex_total)
+        vtx = (nk_byte*)nk_buffer_alloc(vertices, NK_BUFFER_FRONT,
+            vertex_total * list->vertex_size, list->vertex_alignment);
+    if (element_total)
+        idx = (nk_byte*)nk_buffer_alloc(elements, NK_BUFFER_FRONT,
+            element_total * element_size, element_size);
+    if ((!vtx && vertex_total) || (!idx && element_total))
+        job_count = 0;
+
+    for (i = 0; i < job_count; ++i) {
+        nk_convert_merge(list, &jobs[i], vtx, idx);
+        vtx += jobs[i].list.vertex_count * list->vertex_size;
+        idx += jobs[i].list.element_count * element_size;
+    }
+    for (i = 0; i < capacity; ++i) {
+        nk_buffer_free(&jobs[i].cmds);
+        nk_buffer_free(&jobs[i].vertices);
+        nk_buffer_free(&jobs[i].elements);
+    }
+    dispatcher->alloc.free(dispatcher->alloc.userdata, jobs);
+}
+
+/* measuring replays the draw command state changes of `nk_convert_command`
+ * and counts the vertices and elements each shape would produce */
+struct nk_convert_measure {
+    struct nk_draw_list list; /* conversion settings only */
+    struct nk_draw_command last; /* state of the last draw command */
+    unsigned int cmd_count;
+    nk_size vertex_count;
+    nk_size element_count;
+    nk_size vertex_bytes; /* including temporary memory */
+};
+
+NK_INTERN void
+nk_convert_measure_push(struct nk_convert_measure *m, struct nk_rect clip,
+    nk_handle texture)
+{
+    m->last.elem_count = 0;
+    m->last.clip_rect = clip;
+    m->last.texture = texture;
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    m->last.userdata = m->list.userdata;
+#endif
+    m->list.clip_rect = clip;
+    m->cmd_count++;
+}
+
+NK_INTERN void
+nk_convert_measure_clip(struct nk_convert_measure *m, struct nk_rect rect)
+{
+    /* `nk_draw_list_add_clip` always starts a new command */
+    nk_handle texture = (m->cmd_count) ? m->last.texture: m->list.null.texture;
+    nk_convert_measure_push(m, rect, texture);
+}
+
+NK_INTERN void
+nk_convert_measure_image(struct nk_convert_measure *m, nk_handle texture)
+{
+    if (!m->cmd_count)
+        nk_convert_measure_push(m, nk_null_rect, texture);
+    else if (!m->last.elem_count)
+        m->last.texture = texture;
+    else if (m->last.texture.id != texture.id)
+        nk_convert_measure_push(m, m->last.clip_rect, texture);
+}
+
+NK_INTERN void
+nk_convert_measure_userdata(struct nk_convert_measure *m)
+{
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    if (!m->cmd_count)
+        nk_convert_measure_push(m, nk_null_rect, m->list.null.texture);
+    else if (!m->last.elem_count)
+        m->last.userdata = m->list.userdata;
+    else if (m->last.userdata.ptr != m->list.userdata.ptr)
+        nk_convert_measure_push(m, m->last.clip_rect, m->last.texture);
+#else
+    NK_UNUSED(m);
+#endif
+}
+
+NK_INTERN void
+nk_convert_measure_shape(struct nk_convert_measure *m)
+{
+    /* command state of paths and `nk_draw_list_shape_state` */
+    if (!m->cmd_count)
+        nk_convert_measure_clip(m, nk_null_rect);
+    if (m->last.texture.ptr != m->list.null.texture.ptr)
+        nk_convert_measure_image(m, m->list.null.texture);
+}
+
+NK_INTERN void
+nk_convert_measure_emit(struct nk_convert_measure *m, nk_size vtx_count,
+    nk_size idx_count)
+{
+    if (m->list.index_type == NK_INDEX_16BIT_SPLIT &&
+        (m->vertex_count - m->last.vertex_offset) + vtx_count > 0xFFFF + 1) {
+        if (m->last.elem_count) {
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+            nk_handle userdata = m->last.userdata;
+            nk_convert_measure_push(m, m->last.clip_rect, m->last.texture);
+            m->last.userdata = userdata;
+#else
+            nk_convert_measure_push(m, m->last.clip_rect, m->last.texture);
+#endif
+        }
+        m->last.vertex_offset = (unsigned int)m->vertex_count;
+    }
+    m->vertex_count += vtx_count;
+    m->element_count += idx_count;
+    m->last.elem_count += (unsigned int)idx_count;
+    m->vertex_bytes = NK_MAX(m->vertex_bytes, m->vertex_count * m->list.vertex_size);
+}
+
+NK_INTERN void
+nk_convert_measure_scratch(struct nk_convert_measure *m, nk_size count)
+{
+    /* anti-aliased shapes temporarily allocate `count` points behind
+     * their vertices */
+    NK_STORAGE const nk_size pnt_align = NK_ALIGNOF(struct nk_vec2);
+    nk_size end = m->vertex_count * m->list.vertex_size;
+    end += (pnt_align - end % pnt_align) % pnt_align;
+    end += count * sizeof(struct nk_vec2);
+    m->vertex_bytes = NK_MAX(m->vertex_bytes, end);
+}
+
+NK_INTERN unsigned int
+nk_convert_measure_path(struct nk_convert_measure *m, unsigned int points)
+{
+    if (points) nk_convert_measure_shape(m);
+    return points;
+}
+
+NK_INTERN void
+nk_convert_measure_fill(struct nk_convert_measure *m, unsigned int points)
+{
+    /* `nk_draw_list_fill_poly_convex` */
+    if (points < 3) return;
+    nk_convert_measure_userdata(m);
+    if (m->list.shape_AA == NK_ANTI_ALIASING_ON) {
+        nk_convert_measure_emit(m, points*2, (points-2)*3 + points*6);
+        nk_convert_measure_scratch(m, points);
+    } else nk_convert_measure_emit(m, points, (points-2)*3);
+}
+
+NK_INTERN void
+nk_convert_measure_stroke(struct nk_convert_measure *m, unsigned int points,
+    enum nk_draw_list_stroke closed, float thickness)
+{
+    /* `nk_draw_list_stroke_poly_line` */
+    nk_size count;
+    if (points < 2) return;
+    count = (closed) ? points: points-1;
+    nk_convert_measure_userdata(m);
+    if (m->list.line_AA == NK_ANTI_ALIASING_ON) {
+        if (thickness > 1.0f) {
+            nk_convert_measure_emit(m, points * 4, count * 18);
+            nk_convert_measure_scratch(m, points * 5);
+        } else {
+            nk_convert_measure_emit(m, points * 3, count * 12);
+            nk_convert_measure_scratch(m, points * 3);
+        }
+    } else nk_convert_measure_emit(m, count * 4, count * 6);
+}
+
+NK_INTERN unsigned int
+nk_convert_measure_arc(struct nk_convert_measure *m, float radius,
+    float a_min, float a_max, unsigned int segments)
+{
+    /* points of `nk_draw_list_path_arc_to` */
+    if (radius == 0.0f) return 0;
+    return nk_draw_list_arc_segments(&m->list, radius, a_min, a_max, segments) + 1;
+}
+
+NK_INTERN unsigned int
+nk_convert_measure_circle(struct nk_convert_measure *m, float radius,
+    unsigned int segs)
+{
+    /* points of `nk_draw_list_fill_circle` and `nk_draw_list_stroke_circle` */
+    const unsigned int table = (unsigned int)NK_LEN(m->list.circle_vtx);
+    unsigned int n, step;
+    if (m->list.curve_tolerance <= 0.0f) {
+        float a_max = NK_PI * 2.0f * ((float)segs - 1.0f) / (float)segs;
+        return nk_convert_measure_arc(m, radius, 0.0f, a_max, segs);
+    }
+    n = nk_draw_list_circle_segments(&m->list, radius);
+    if (n > table) return n;
+    step = table / n;
+    return (table - step) / step + 1;
+}
+
+NK_INTERN unsigned int
+nk_convert_measure_rect_path(struct nk_convert_measure *m, struct nk_vec2 a,
+    struct nk_vec2 b, float rounding)
+{
+    /* points of `nk_draw_list_path_rect_to` */
+    const unsigned int table = (unsigned int)NK_LEN(m->list.circle_vtx);
+    const unsigned int q = table / 4;
+    unsigned int n;
+    float r = rounding;
+    r = NK_MIN(r, ((b.x-a.x) < 0) ? -(b.x-a.x): (b.x-a.x));
+    r = NK_MIN(r, ((b.y-a.y) < 0) ? -(b.y-a.y): (b.y-a.y));
+    if (r == 0.0f) return 4;
+    if (m->list.curve_tolerance <= 0.0f)
+        return 4 * (3 + 1);
+    n = nk_draw_list_circle_segments(&m->list, r);
+    if (n <= table)
+        return 4 * (q / (table / n) + 1);
+    return nk_convert_measure_arc(m, r, NK_PI, 1.5f*NK_PI, 0) +
+        nk_convert_measure_arc(m, r, 1.5f*NK_PI, 2.0f*NK_PI, 0) +
+        nk_convert_measure_arc(m, r, 0.0f, 0.5f*NK_PI, 0) +
+        nk_convert_measure_arc(m, r, 0.5f*NK_PI, NK_PI, 0);
+}
+
+NK_INTERN void
+nk_convert_measure_rect(struct nk_convert_measure *m, struct nk_rect rect,
+    struct nk_color col, float rounding, float thickness, int filled)
+{
+    /* `nk_draw_list_fill_rect` and `nk_draw_list_stroke_rect` */
+    const struct nk_vec2 a = nk_vec2(rect.x + 0.5f, rect.y + 0.5f);
+    const struct nk_vec2 b = nk_vec2(rect.x + rect.w + 0.5f, rect.y + rect.h + 0.5f);
+    const float w = b.x - a.x;
+    const float h = b.y - a.y;
+    unsigned int points;
+    if (!col.a) return;
+    if (rounding == 0.0f && w > 0.0f && h > 0.0f) {
+        nk_convert_measure_shape(m);
+        nk_convert_measure_userdata(m);
+        if (filled && m->list.shape_AA == NK_ANTI_ALIASING_ON)
+            nk_convert_measure_emit(m, 8, 30);
+        else if (filled)
+            nk_convert_measure_emit(m, 4, 6);
+        else if (m->list.line_AA == NK_ANTI_ALIASING_ON && thickness <= 1.0f)
+            nk_convert_measure_emit(m, 12, 48);
+        else if (m->list.line_AA == NK_ANTI_ALIASING_ON)
+            nk_convert_measure_emit(m, 16, 72);
+        else nk_convert_measure_emit(m, 16, 24);
+        return;
+    }
+    points = nk_convert_measure_path(m, nk_convert_measure_rect_path(m, a, b, rounding));
+    if (filled) nk_convert_measure_fill(m, points);
+    else nk_convert_measure_stroke(m, points, NK_STROKE_CLOSED, thickness);
+}
+
+NK_INTERN void
+nk_convert_measure_text(struct nk_convert_measure *m, const struct nk_user_font *font,
+    struct nk_rect rect, const char *text, int len, float font_height)
+{
+    /* `nk_draw_list_add_text` emits a quad for every glyph */
+    const struct nk_rect clip = m->list.clip_rect;
+    int text_len = 0;
+    nk_rune unicode = 0;
+    nk_rune next = 0;
+    int glyph_len = 0;
+    int next_glyph_len = 0;
+    struct nk_user_font_glyph g;
+    nk_handle texture;
+
+    if (!len || !text) return;
+    if (rect.x > (clip.x + clip.w) || rect.y > (clip.y + clip.h) ||
+        rect.x < clip.x || rect.y < clip.y)
+        return;
+
+    texture = font->texture;
+    nk_convert_measure_image(m, texture);
+    glyph_len = text_len = nk_utf_decode(text, &unicode, len);
+    if (!glyph_len) return;
+    while (text_len <= len && glyph_len) {
+        if (unicode == NK_UTF_INVALID) break;
+        next = 0;
+        next_glyph_len = nk_utf_decode(text + text_len, &next, (int)len - text_len);
+        g.texture = font->texture;
+        font->query(font->userdata, font_height, &g, unicode,
+                    (next == NK_UTF_INVALID) ? '\0' : next);
+        if (g.texture.id != texture.id) {
+            texture = g.texture;
+            nk_convert_measure_image(m, texture);
+        }
+        nk_convert_measure_emit(m, 4, 6);
+        glyph_len = next_glyph_len;
+        text_len += glyph_len;
+        unicode = next;
+    }
+}
+
+NK_INTERN void
+nk_convert_measure_polygon(struct nk_convert_measure *m, unsigned short point_count,
+    float thickness, enum nk_command_type type)
+{
+    /* polygons are converted even with a transparent color */
+    unsigned int points = nk_convert_measure_path(m, point_count);
+    if (type == NK_COMMAND_POLYGON_FILLED)
+        nk_convert_measure_fill(m, points);
+    else nk_convert_measure_stroke(m, points, (type == NK_COMMAND_POLYGON) ?
+        NK_STROKE_CLOSED: NK_STROKE_OPEN, thickness);
+}
+
+NK_INTERN void
+nk_convert_measure_command(struct nk_convert_measure *m, const struct nk_command *cmd,
+    const struct nk_convert_config *config)
+{
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    m->list.userdata = cmd->userdata;
+#endif
+    switch (cmd->type) {
+    case NK_COMMAND_SCISSOR: {
+        const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
+        nk_convert_measure_clip(m, nk_rect(s->x, s->y, s->w, s->h));
+    } break;
+    case NK_COMMAND_LINE: {
+        const struct nk_command_line *l = (const struct nk_command_line*)cmd;
+        if (!l->color.a) break;
+        nk_convert_measure_stroke(m, nk_convert_measure_path(m, 2),
+            NK_STROKE_OPEN, l->line_thickness);
+    } break;
+    case NK_COMMAND_CURVE: {
+        const struct nk_command_curve *q = (const struct nk_command_curve*)cmd;
+        unsigned int n;
+        if (!q->color.a) break;
+        n = nk_draw_list_curve_segments(&m->list, nk_vec2(q->begin.x, q->begin.y),
+            nk_vec2(q->ctrl[0].x, q->ctrl[0].y), nk_vec2(q->ctrl[1].x, q->ctrl[1].y),
+            nk_vec2(q->end.x, q->end.y), config->curve_segment_count);
+        nk_convert_measure_stroke(m, nk_convert_measure_path(m, 1 + n),
+            NK_STROKE_OPEN, q->line_thickness);
+    } break;
+    case NK_COMMAND_RECT: {
+        const struct nk_command_rect *r = (const struct nk_command_rect*)cmd;
+        nk_convert_measure_rect(m, nk_rect(r->x, r->y, r->w, r->h),
+            r->color, (float)r->rounding, r->line_thickness, nk_false);
+    } break;
+    case NK_COMMAND_RECT_FILLED: {
+        const struct nk_command_rect_filled *r = (const struct nk_command_rect_filled*)cmd;
+        nk_convert_measure_rect(m, nk_rect(r->x, r->y, r->w, r->h),
+            r->color, (float)r->rounding, 0.0f, nk_true);
+    } break;
+    case NK_COMMAND_RECT_MULTI_COLOR: {
+        nk_convert_measure_image(m, m->list.null.texture);
+        nk_convert_measure_emit(m, 4, 6);
+    } break;
+    case NK_COMMAND_CIRCLE: {
+        const struct nk_command_circle *c = (const struct nk_command_circle*)cmd;
+        unsigned int n;
+        if (!c->color.a) break;
+        n = nk_convert_measure_circle(m, (float)c->w/2, config->circle_segment_count);
+        nk_convert_measure_stroke(m, nk_convert_measure_path(m, n),
+            NK_STROKE_CLOSED, c->line_thickness);
+    } break;
+    case NK_COMMAND_CIRCLE_FILLED: {
+        const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled*)cmd;
+        unsigned int n;
+        if (!c->color.a) break;
+        n = nk_convert_measure_circle(m, (float)c->w/2, config->circle_segment_count);
+        nk_convert_measure_fill(m, nk_convert_measure_path(m, n));
+    } break;
+    case NK_COMMAND_ARC: {
+        const struct nk_command_arc *c = (const struct nk_command_arc*)cmd;
+        unsigned int n = 1 + nk_convert_measure_arc(m, c->r, c->a[0], c->a[1],
+            config->arc_segment_count);
+        nk_convert_measure_stroke(m, nk_convert_measure_path(m, n),
+            NK_STROKE_CLOSED, c->line_thickness);
+    } break;
+    case NK_COMMAND_ARC_FILLED: {
+        const struct nk_command_arc_filled *c = (const struct nk_command_arc_filled*)cmd;
+        unsigned int n = 1 + nk_convert_measure_arc(m, c->r, c->a[0], c->a[1],
+            config->arc_segment_count);
+        nk_convert_measure_fill(m, nk_convert_measure_path(m, n));
+    } break;
+    case NK_COMMAND_TRIANGLE: {
+        const struct nk_command_triangle *t = (const struct nk_command_triangle*)cmd;
+        if (!t->color.a) break;
+        nk_convert_measure_stroke(m, nk_convert_measure_path(m, 3),
+            NK_STROKE_CLOSED, t->line_thickness);
+    } break;
+    case NK_COMMAND_TRIANGLE_FILLED: {
+        const struct nk_command_triangle_filled *t = (const struct nk_command_triangle_filled*)cmd;
+        if (!t->color.a) break;
+        nk_convert_measure_fill(m, nk_convert_measure_path(m, 3));
+    } break;
+    case NK_COMMAND_POLYGON: {
+        const struct nk_command_polygon *p = (const struct nk_command_polygon*)cmd;
+        nk_convert_measure_polygon(m, p->point_count, p->line_thickness, cmd->type);
+    } break;
+    case NK_COMMAND_POLYGON_FILLED: {
+        const struct nk_command_polygon_filled *p = (const struct nk_command_polygon_filled*)cmd;
+        nk_convert_measure_polygon(m, p->point_count, 0.0f, cmd->type);
+    } break;
+    case NK_COMMAND_POLYLINE: {
+        const struct nk_command_polyline *p = (const struct nk_command_polyline*)cmd;
+        nk_convert_measure_polygon(m, p->point_count, p->line_thickness, cmd->type);
+    } break;
+    case NK_COMMAND_TEXT: {
+        const struct nk_command_text *t = (const struct nk_command_text*)cmd;
+        nk_convert_measure_text(m, t->font, nk_rect(t->x, t->y, t->w, t->h),
+            t->string, t->length, t->height);
+    } break;
+    case NK_COMMAND_IMAGE: {
+        const struct nk_command_image *i = (const struct nk_command_image*)cmd;
+        nk_convert_measure_image(m, i->img.handle);
+        nk_convert_measure_emit(m, 4, 6);
+    } break;
+    default: break;
+    }
+}
+
+NK_API void
+nk_convert_measure(struct nk_context *ctx, const struct nk_convert_config *config,
+    nk_size *vertex_bytes, nk_size *element_bytes, unsigned int *cmd_count)
+{
+    struct nk_convert_measure m;
+    const struct nk_command *cmd;
+    NK_ASSERT(ctx);
+    NK_ASSERT(config);
+    if (!ctx || !config) return;
+
+    nk_zero(&m, sizeof(m));
+    nk_convert_setup(&m.list, config, 0, 0, 0);
+    nk_foreach(cmd, ctx)
+        nk_convert_measure_command(&m, cmd, config);
+    if (vertex_bytes) *vertex_bytes = m.vertex_bytes;
+    if (element_bytes) *element_bytes = m.element_count *
+        ((m.list.index_type == NK_INDEX_32BIT) ? sizeof(nk_uint): sizeof(nk_ushort));
+    if (cmd_count) *cmd_count = m.cmd_count;
+}
+
+NK_INTERN int
+nk_convert_stream_fits(struct nk_convert_measure *m, const struct nk_draw_list *list,
+    const struct nk_command *cmd, const struct nk_convert_config *config,
+    const struct nk_convert_stream *stream)
+{
+    /* measures the command on top of the current chunk */
+    nk_size element_size = (list->index_type == NK_INDEX_32BIT) ?
+        sizeof(nk_uint): sizeof(nk_ushort);
+    m->vertex_count = list->vertex_count;
+    m->element_count = list->element_count;
+    m->vertex_bytes = 0;
+    m->list.clip_rect = list->clip_rect;
+    nk_convert_measure_command(m, cmd, config);
+    if (list->index_type == NK_INDEX_16BIT && m->vertex_count > 0xFFFF + 1)
+        return nk_false;
+    return m->vertex_bytes <= stream->vertex_capacity &&
+        m->element_count * element_size <= stream->element_capacity;
+}
+
+NK_INTERN void
+nk_convert_stream_flush(struct nk_draw_list *list, const struct nk_convert_stream *stream,
+    struct nk_buffer *vertices, struct nk_buffer *elements)
+{
+    /* hands the chunk to the user and continues the draw state in a new one */
+    struct nk_draw_command *last = nk_draw_list_command_last(list);
+    struct nk_rect clip = last->clip_rect;
+    nk_handle texture = last->texture;
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    nk_handle userdata = last->userdata;
+#endif
+    void *vtx = nk_buffer_memory(vertices);
+    void *idx = nk_buffer_memory(elements);
+
+    stream->flush(stream->userdata, list, list->buffer, &vtx, &idx);
+    nk_buffer_init_fixed(vertices, vtx, stream->vertex_capacity);
+    nk_buffer_init_fixed(elements, idx, stream->element_capacity);
+    nk_buffer_clear(list->buffer);
+    list->element_count = 0;
+    list->vertex_count = 0;
+    list->cmd_offset = 0;
+    list->cmd_count = 0;
+    last = nk_draw_list_push_command(list, clip, texture);
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    if (last) last->userdata = userdata;
+#endif
+}
+
+NK_API void
+nk_convert_chunked(struct nk_context *ctx, struct nk_buffer *cmds,
+    const struct nk_convert_config *config, const struct nk_convert_stream *stream)
+{
+    struct nk_convert_measure m;
+    struct nk_buffer vertices;
+    struct nk_buffer elements;
+    struct nk_draw_list *list;
+    const struct nk_command *cmd;
+
+    NK_ASSERT(ctx);
+    NK_ASSERT(cmds);
+    NK_ASSERT(config);
+    NK_ASSERT(stream);
+    if (!ctx || !cmds || !config || !stream || !stream->flush)
+        return;
+
+    list = &ctx->draw_list;
+    nk_buffer_init_fixed(&vertices, stream->vertices, stream->vertex_capacity);
+    nk_buffer_init_fixed(&elements, stream->elements, stream->element_capacity);
+    nk_convert_setup(list, config, cmds, &vertices, &elements);
+    nk_zero(&m, sizeof(m));
+    nk_convert_setup(&m.list, config, 0, 0, 0);
+
+    nk_foreach(cmd, ctx) {
+        int fits = nk_convert_stream_fits(&m, list, cmd, config, stream);
+        if (!fits && list->element_count) {
+            nk_convert_stream_flush(list, stream, &vertices, &elements);
+            fits = nk_convert_stream_fits(&m, list, cmd, config, stream);
         }
+        NK_ASSERT(fits && "shape does not fit into an empty chunk");
+        if (fits) nk_convert_command(list, cmd, config);
+    }
+    if (list->element_count) {
+        void *vtx = nk_buffer_memory(&vertices);
+        void *idx = nk_buffer_memory(&elements);
+        stream->flush(stream->userdata, list, cmds, &vtx, &idx);
     }
+    /* the chunk buffers only live until here */
+    nk_draw_list_clear(list);
 }
 
 NK_API const struct nk_draw_command*
@@ -6618,6 +8768,10 @@ struct nk_rp_context {
     int init_mode;
     int heuristic;
     int num_nodes;
+    int max_width, max_height;
+    /* size limit for growing the target or 0 if the target has a fixed size */
+    int bottom;
+    /* lowest edge of all packed rects */
     struct nk_rp_node *active_head;
     struct nk_rp_node *free_head;
     struct nk_rp_node extra[2];
@@ -6656,6 +8810,25 @@ nk_rp_setup_allow_out_of_mem(struct nk_rp_context *context, int allow_out_of_mem
     }
 }
 
+NK_INTERN void
+nk_rp_setup_heuristic(struct nk_rp_context *context, int heuristic)
+{
+    /* bottom-left places each rect as high as possible while best-fit
+     * also tries right aligned positions and picks the least wasted area */
+    NK_ASSERT(context->init_mode == NK_RP__INIT_skyline);
+    context->heuristic = heuristic;
+}
+
+NK_INTERN void
+nk_rp_setup_growth(struct nk_rp_context *context, int max_width, int max_height)
+{
+    /* lets the target double its smaller side up to the given size whenever
+     * a rect does not fit. Width only grows while nodes are left, so pass
+     * `max_width` nodes to `nk_rp_init_target` */
+    context->max_width = max_width;
+    context->max_height = max_height;
+}
+
 NK_INTERN void
 nk_rp_init_target(struct nk_rp_context *context, int width, int height,
     struct nk_rp_node *nodes, int num_nodes)
@@ -6675,6 +8848,9 @@ nk_rp_init_target(struct nk_rp_context *context, int width, int height,
     context->width = width;
     context->height = height;
     context->num_nodes = num_nodes;
+    context->max_width = 0;
+    context->max_height = 0;
+    context->bottom = 0;
     nk_rp_setup_allow_out_of_mem(context, 0);
 
     /* node 0 is the full width, node 1 is the sentinel (lets us not store width explicitly) */
@@ -6743,6 +8919,13 @@ nk_rp__skyline_find_best_pos(struct nk_rp_context *c, int width, int height)
     width -= width % c->align;
     NK_ASSERT(width % c->align == 0);
 
+    /* rects larger than the target can never fit */
+    if (width > c->width || height > c->height) {
+        fr.prev_link = 0;
+        fr.x = fr.y = 0;
+        return fr;
+    }
+
     node = c->active_head;
     prev = &c->active_head;
     while (node->x + width <= c->width) {
@@ -6880,6 +9063,35 @@ nk_rp__skyline_pack_rectangle(struct nk_rp_context *context, int width, int heig
     return res;
 }
 
+NK_INTERN int
+nk_rp__grow_target(struct nk_rp_context *c, int width)
+{
+    /* doubles the target to fit a rect of the given width. Packed rects keep
+     * their position since the skyline only extends to the right and down */
+    int grow_width = c->width < c->max_width && (width > c->width ||
+        c->width <= c->height || c->height >= c->max_height);
+    if (grow_width && c->free_head) {
+        struct nk_rp_node *node = c->free_head, *last = c->active_head;
+        while (last->next != &c->extra[1])
+            last = last->next;
+
+        /* new empty skyline segment between old and new right border */
+        c->free_head = node->next;
+        node->x = (nk_rp_coord)c->width;
+        node->y = 0;
+        node->next = &c->extra[1];
+        last->next = node;
+        c->width = NK_MIN(c->width * 2, c->max_width);
+        c->extra[1].x = (nk_rp_coord)c->width;
+        return 1;
+    }
+    if (c->height < c->max_height) {
+        c->height = NK_MIN(c->height * 2, c->max_height);
+        return 1;
+    }
+    return 0;
+}
+
 NK_INTERN int
 nk_rect_height_compare(const void *a, const void *b)
 {
@@ -6944,9 +9156,12 @@ nk_rp_pack_rects(struct nk_rp_context *context, struct nk_rp_rect *rects, int nu
 
     for (i=0; i < num_rects; ++i) {
         struct nk_rp__findresult fr = nk_rp__skyline_pack_rectangle(context, rects[i].w, rects[i].h);
+        while (!fr.prev_link && nk_rp__grow_target(context, rects[i].w))
+            fr = nk_rp__skyline_pack_rectangle(context, rects[i].w, rects[i].h);
         if (fr.prev_link) {
             rects[i].x = (nk_rp_coord) fr.x;
             rects[i].y = (nk_rp_coord) fr.y;
+            context->bottom = NK_MAX(context->bottom, fr.y + rects[i].h);
         } else {
             rects[i].x = rects[i].y = NK_RP__MAXVAL;
         }
@@ -6971,6 +9186,16 @@ nk_rp_pack_rects(struct nk_rp_context *context, struct nk_rp_rect *rects, int nu
 #define NK_TT_MAX_OVERSAMPLE   8
 #define NK_TT__OVER_MASK  (NK_TT_MAX_OVERSAMPLE-1)
 
+#ifndef NK_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NK_TT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NK_TT_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
 struct nk_tt_bakedchar {
     unsigned short x0,y0,x1,y1;
     /* coordinates of bbox in bitmap */
@@ -6997,7 +9222,7 @@ struct nk_tt_pack_range {
     /* if non-zero, then this is an array of unicode codepoints */
     int num_chars;
     struct nk_tt_packedchar *chardata_for_range; /* output */
-    unsigned char h_oversample, v_oversample;
+    unsigned char h_oversample, v_oversample, sdf_spread;
     /* don't set these, they're used internally */
 };
 
@@ -7008,6 +9233,7 @@ struct nk_tt_pack_context {
     int   stride_in_bytes;
     int   padding;
     unsigned int   h_oversample, v_oversample;
+    unsigned int   sdf_spread;
     unsigned char *pixels;
     void  *nodes;
 };
@@ -7604,6 +9830,19 @@ nk_tt_GetGlyphHMetrics(const struct nk_tt_fontinfo *info, int glyph_index,
     }
 }
 
+NK_INTERN int
+nk_tt_GetKerningPairs(const struct nk_tt_fontinfo *info, const nk_byte **pairs)
+{
+    /* only the first subtable of the `kern` table is used and only if it is
+     * horizontal format 0. Each pair is (left glyph, right glyph, value) */
+    const nk_byte *data = info->data + info->kern;
+    if (!info->kern) return 0;
+    if (nk_ttUSHORT(data+2) < 1) return 0; /* number of tables */
+    if (nk_ttUSHORT(data+8) != 1) return 0; /* horizontal flag, format 0 */
+    *pairs = data + 18;
+    return nk_ttUSHORT(data+10);
+}
+
 NK_INTERN void
 nk_tt_GetFontVMetrics(const struct nk_tt_fontinfo *info,
     int *ascent, int *descent, int *lineGap)
@@ -7918,13 +10157,64 @@ nk_tt__fill_active_edges_new(float *scanline, float *scanline_fill, int len,
 }
 
 /* directly AA rasterize edges w/o supersampling */
+NK_INTERN void
+nk_tt__store_scanline(unsigned char *pixels, const float *scanline,
+    float *scanline_fill, int len)
+{
+    /* converts accumulated scanline coverage into bytes. The prefix sum over
+     * `scanline_fill` stays sequential so vector code computes the same bytes */
+    float sum = 0;
+    int i;
+    for (i = 0; i < len; ++i) {
+        sum += scanline_fill[i];
+        scanline_fill[i] = sum;
+    }
+    i = 0;
+#if defined(NK_TT_SSE2)
+    {const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 8 <= len; i += 8) {
+        __m128 k0 = _mm_add_ps(_mm_loadu_ps(scanline + i), _mm_loadu_ps(scanline_fill + i));
+        __m128 k1 = _mm_add_ps(_mm_loadu_ps(scanline + i + 4), _mm_loadu_ps(scanline_fill + i + 4));
+        __m128i m0, m1;
+        k0 = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, k0), scale), half);
+        k1 = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, k1), scale), half);
+        m0 = _mm_cvttps_epi32(_mm_min_ps(k0, scale));
+        m1 = _mm_cvttps_epi32(_mm_min_ps(k1, scale));
+        m0 = _mm_packs_epi32(m0, m1);
+        _mm_storel_epi64((__m128i*)(void*)(pixels + i), _mm_packus_epi16(m0, m0));
+    }}
+#elif defined(NK_TT_NEON)
+    {const float32x4_t scale = vdupq_n_f32(255.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    for (; i + 8 <= len; i += 8) {
+        float32x4_t k0 = vaddq_f32(vld1q_f32(scanline + i), vld1q_f32(scanline_fill + i));
+        float32x4_t k1 = vaddq_f32(vld1q_f32(scanline + i + 4), vld1q_f32(scanline_fill + i + 4));
+        uint16x8_t m;
+        k0 = vminq_f32(vaddq_f32(vmulq_f32(vabsq_f32(k0), scale), half), scale);
+        k1 = vminq_f32(vaddq_f32(vmulq_f32(vabsq_f32(k1), scale), half), scale);
+        m = vcombine_u16(vmovn_u32(vcvtq_u32_f32(k0)), vmovn_u32(vcvtq_u32_f32(k1)));
+        vst1_u8(pixels + i, vmovn_u16(m));
+    }}
+#endif
+    for (; i < len; ++i) {
+        float k = scanline[i] + scanline_fill[i];
+        int m;
+        k = (float) NK_ABS(k) * 255.0f + 0.5f;
+        m = (int) k;
+        if (m > 255) m = 255;
+        pixels[i] = (unsigned char) m;
+    }
+}
+
 NK_INTERN void
 nk_tt__rasterize_sorted_edges(struct nk_tt__bitmap *result, struct nk_tt__edge *e,
     int n, int vsubsample, int off_x, int off_y, struct nk_allocator *alloc)
 {
     struct nk_tt__hheap hh;
     struct nk_tt__active_edge *active = 0;
-    int y,j=0, i;
+    int y,j=0;
     float scanline_data[129], *scanline, *scanline2;
 
     NK_UNUSED(vsubsample);
@@ -7981,19 +10271,8 @@ nk_tt__rasterize_sorted_edges(struct nk_tt__bitmap *result, struct nk_tt__edge *
         if (active)
             nk_tt__fill_active_edges_new(scanline, scanline2+1, result->w, active, scan_y_top);
 
-        {
-            float sum = 0;
-            for (i=0; i < result->w; ++i) {
-                float k;
-                int m;
-                sum += scanline2[i];
-                k = scanline[i] + sum;
-                k = (float) NK_ABS(k) * 255.0f + 0.5f;
-                m = (int) k;
-                if (m > 255) m = 255;
-                result->pixels[j*result->stride + i] = (unsigned char) m;
-            }
-        }
+        nk_tt__store_scanline(result->pixels + j*result->stride,
+            scanline, scanline2, result->w);
         /* advance all the edges */
         step = &active;
         while (*step) {
@@ -8319,6 +10598,79 @@ nk_tt_MakeGlyphBitmapSubpixel(const struct nk_tt_fontinfo *info, unsigned char *
     alloc->free(alloc->userdata, vertices);
 }
 
+NK_INTERN void
+nk_tt_MakeGlyphSDF(const struct nk_tt_fontinfo *info, unsigned char *output,
+    int out_w, int out_h, int out_stride, float scale, int spread, int glyph,
+    struct nk_allocator *alloc)
+{
+    /* stores the signed distance of each pixel center to the glyph outline.
+     * The bitmap box is extended by `spread` on each side and distances
+     * between -spread (outside) and spread (inside) map to 0-255 with the
+     * outline at 128 */
+    int ix0, iy0, x, y, i, j, k;
+    int winding_count = 0, *winding_lengths = 0;
+    struct nk_tt__point *windings = 0;
+    struct nk_tt_vertex *vertices;
+    int num_verts = nk_tt_GetGlyphShape(info, alloc, glyph, &vertices);
+
+    nk_tt_GetGlyphBitmapBoxSubpixel(info, glyph, scale, scale, 0,0, &ix0,&iy0,0,0);
+    if (num_verts > 0)
+        windings = nk_tt_FlattenCurves(vertices, num_verts, 0.35f / scale,
+            &winding_lengths, &winding_count, alloc);
+    alloc->free(alloc->userdata, vertices);
+
+    /* move outline into output pixel space with y pointing down */
+    for (i = 0, k = 0; i < winding_count; ++i) {
+        for (j = 0; j < winding_lengths[i]; ++j, ++k) {
+            windings[k].x = windings[k].x * scale - (float)(ix0 - spread);
+            windings[k].y = -windings[k].y * scale - (float)(iy0 - spread);
+        }
+    }
+
+    for (y = 0; y < out_h; ++y) {
+        for (x = 0; x < out_w; ++x) {
+            const struct nk_tt__point *contour = windings;
+            float px = (float)x + 0.5f, py = (float)y + 0.5f;
+            float dist = (float)(spread * spread);
+            float value;
+            int winding = 0;
+
+            for (i = 0; i < winding_count; ++i) {
+                int n = winding_lengths[i];
+                for (j = 0, k = n - 1; j < n; k = j++) {
+                    struct nk_tt__point a = contour[k], b = contour[j];
+                    float dx = b.x - a.x, dy = b.y - a.y;
+                    float len = dx * dx + dy * dy;
+                    float t = 0, ex, ey;
+
+                    /* non-zero winding rule with a ray to the right */
+                    if ((a.y <= py) != (b.y <= py)) {
+                        float cx = a.x + (py - a.y) / dy * dx;
+                        if (px < cx) winding += (dy > 0) ? 1: -1;
+                    }
+                    /* squared distance to the closest point on the edge */
+                    if (len > 0) {
+                        t = ((px - a.x) * dx + (py - a.y) * dy) / len;
+                        t = NK_CLAMP(0.0f, t, 1.0f);
+                    }
+                    ex = a.x + t * dx - px;
+                    ey = a.y + t * dy - py;
+                    dist = NK_MIN(dist, ex * ex + ey * ey);
+                }
+                contour += n;
+            }
+            dist = (dist > 0) ? NK_SQRT(dist): 0;
+            if (!winding) dist = -dist;
+            value = 127.5f + dist * 127.5f / (float)spread;
+            output[y * out_stride + x] = (unsigned char)NK_CLAMP(0.0f, value + 0.5f, 255.0f);
+        }
+    }
+    if (windings) {
+        alloc->free(alloc->userdata, winding_lengths);
+        alloc->free(alloc->userdata, windings);
+    }
+}
+
 /*-------------------------------------------------------------
  *                          Bitmap baking
  * --------------------------------------------------------------*/
@@ -8373,6 +10725,127 @@ nk_tt_PackSetOversampling(struct nk_tt_pack_context *spc,
       spc->v_oversample = v_oversample;
 }
 
+#if defined(NK_TT_SSE2) || defined(NK_TT_NEON)
+/* Vector box filters compute the same integer sums as the scalar filters.
+ * Sums stay below 16 bits and are divided by multiplying with ceil(2^16/k)
+ * and keeping the upper 16 bits, which is exact for sums below 2^16/8 */
+NK_INTERN void
+nk_tt__h_prefilter_simd(unsigned char *pixels, int w, int h, int stride_in_bytes,
+    int kernel_width)
+{
+    /* averages each pixel with the kernel_width-1 pixels to its left. Rows
+     * are filtered in place in chunks, so each chunk is copied behind the
+     * last unfiltered pixels of the previous chunk */
+    unsigned char line[NK_TT_MAX_OVERSAMPLE + 64];
+    unsigned char *src = line + NK_TT_MAX_OVERSAMPLE;
+    unsigned short mul = (unsigned short)((65536 + kernel_width - 1) / kernel_width);
+    int i, j, c, d;
+
+    for (j = 0; j < h; ++j) {
+        unsigned char *row = pixels + j * stride_in_bytes;
+        NK_MEMSET(line, 0, NK_TT_MAX_OVERSAMPLE);
+        for (c = 0; c < w; c += 64) {
+            int n = NK_MIN(64, w - c);
+            NK_MEMCPY(src, row + c, (nk_size)n);
+#if defined(NK_TT_SSE2)
+            {const __m128i zero = _mm_setzero_si128();
+            const __m128i m = _mm_set1_epi16((short)mul);
+            for (i = 0; i + 16 <= n; i += 16) {
+                __m128i lo = zero, hi = zero;
+                for (d = 0; d < kernel_width; ++d) {
+                    __m128i x = _mm_loadu_si128((const __m128i*)(const void*)(src + i - d));
+                    lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(x, zero));
+                    hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(x, zero));
+                }
+                lo = _mm_mulhi_epu16(lo, m);
+                hi = _mm_mulhi_epu16(hi, m);
+                _mm_storeu_si128((__m128i*)(void*)(row + c + i), _mm_packus_epi16(lo, hi));
+            }}
+#else
+            {const uint16x4_t m = vdup_n_u16(mul);
+            for (i = 0; i + 16 <= n; i += 16) {
+                uint16x8_t lo = vdupq_n_u16(0), hi = vdupq_n_u16(0);
+                for (d = 0; d < kernel_width; ++d) {
+                    uint8x16_t x = vld1q_u8(src + i - d);
+                    lo = vaddw_u8(lo, vget_low_u8(x));
+                    hi = vaddw_u8(hi, vget_high_u8(x));
+                }
+                lo = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(lo), m), 16),
+                    vshrn_n_u32(vmull_u16(vget_high_u16(lo), m), 16));
+                hi = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(hi), m), 16),
+                    vshrn_n_u32(vmull_u16(vget_high_u16(hi), m), 16));
+                vst1q_u8(row + c + i, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+            }}
+#endif
+            for (; i < n; ++i) {
+                unsigned int total = 0;
+                for (d = 0; d < kernel_width; ++d)
+                    total += src[i - d];
+                row[c + i] = (unsigned char)(total / (unsigned int)kernel_width);
+            }
+            /* keep the last unfiltered pixels in front of the next chunk */
+            for (d = 0; d < NK_TT_MAX_OVERSAMPLE; ++d)
+                line[d] = line[n + d];
+        }
+    }
+}
+
+NK_INTERN int
+nk_tt__v_prefilter_simd(unsigned char *pixels, int w, int h, int stride_in_bytes,
+    int kernel_width)
+{
+    /* filters 16 columns at once like the scalar filter and returns
+     * the number of filtered columns */
+    unsigned short mul = (unsigned short)((65536 + kernel_width - 1) / kernel_width);
+    int i, j;
+    for (j = 0; j + 16 <= w; j += 16) {
+#if defined(NK_TT_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i m = _mm_set1_epi16((short)mul);
+        __m128i buffer_lo[NK_TT_MAX_OVERSAMPLE], buffer_hi[NK_TT_MAX_OVERSAMPLE];
+        __m128i total_lo = zero, total_hi = zero;
+        for (i = 0; i < NK_TT_MAX_OVERSAMPLE; ++i)
+            buffer_lo[i] = buffer_hi[i] = zero;
+        for (i = 0; i < h; ++i) {
+            unsigned char *p = pixels + i * stride_in_bytes + j;
+            __m128i x = _mm_loadu_si128((const __m128i*)(const void*)p);
+            __m128i x_lo = _mm_unpacklo_epi8(x, zero);
+            __m128i x_hi = _mm_unpackhi_epi8(x, zero);
+            total_lo = _mm_sub_epi16(_mm_add_epi16(total_lo, x_lo), buffer_lo[i & NK_TT__OVER_MASK]);
+            total_hi = _mm_sub_epi16(_mm_add_epi16(total_hi, x_hi), buffer_hi[i & NK_TT__OVER_MASK]);
+            buffer_lo[(i+kernel_width) & NK_TT__OVER_MASK] = x_lo;
+            buffer_hi[(i+kernel_width) & NK_TT__OVER_MASK] = x_hi;
+            _mm_storeu_si128((__m128i*)(void*)p, _mm_packus_epi16(
+                _mm_mulhi_epu16(total_lo, m), _mm_mulhi_epu16(total_hi, m)));
+        }
+#else
+        const uint16x4_t m = vdup_n_u16(mul);
+        uint16x8_t buffer_lo[NK_TT_MAX_OVERSAMPLE], buffer_hi[NK_TT_MAX_OVERSAMPLE];
+        uint16x8_t total_lo = vdupq_n_u16(0), total_hi = vdupq_n_u16(0);
+        for (i = 0; i < NK_TT_MAX_OVERSAMPLE; ++i)
+            buffer_lo[i] = buffer_hi[i] = vdupq_n_u16(0);
+        for (i = 0; i < h; ++i) {
+            unsigned char *p = pixels + i * stride_in_bytes + j;
+            uint8x16_t x = vld1q_u8(p);
+            uint16x8_t x_lo = vmovl_u8(vget_low_u8(x));
+            uint16x8_t x_hi = vmovl_u8(vget_high_u8(x));
+            uint16x8_t lo, hi;
+            total_lo = vsubq_u16(vaddq_u16(total_lo, x_lo), buffer_lo[i & NK_TT__OVER_MASK]);
+            total_hi = vsubq_u16(vaddq_u16(total_hi, x_hi), buffer_hi[i & NK_TT__OVER_MASK]);
+            buffer_lo[(i+kernel_width) & NK_TT__OVER_MASK] = x_lo;
+            buffer_hi[(i+kernel_width) & NK_TT__OVER_MASK] = x_hi;
+            lo = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(total_lo), m), 16),
+                vshrn_n_u32(vmull_u16(vget_high_u16(total_lo), m), 16));
+            hi = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(total_hi), m), 16),
+                vshrn_n_u32(vmull_u16(vget_high_u16(total_hi), m), 16));
+            vst1q_u8(p, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+        }
+#endif
+    }
+    return j;
+}
+#endif
+
 NK_INTERN void
 nk_tt__h_prefilter(unsigned char *pixels, int w, int h, int stride_in_bytes,
     int kernel_width)
@@ -8381,6 +10854,13 @@ nk_tt__h_prefilter(unsigned char *pixels, int w, int h, int stride_in_bytes,
     int safe_w = w - kernel_width;
     int j;
 
+#if defined(NK_TT_SSE2) || defined(NK_TT_NEON)
+    if (w >= 16) {
+        nk_tt__h_prefilter_simd(pixels, w, h, stride_in_bytes, kernel_width);
+        return;
+    }
+#endif
+
     for (j=0; j < h; ++j)
     {
         int i;
@@ -8443,9 +10923,13 @@ nk_tt__v_prefilter(unsigned char *pixels, int w, int h, int stride_in_bytes,
 {
     unsigned char buffer[NK_TT_MAX_OVERSAMPLE];
     int safe_h = h - kernel_width;
-    int j;
+    int j = 0;
 
-    for (j=0; j < w; ++j)
+#if defined(NK_TT_SSE2) || defined(NK_TT_NEON)
+    j = nk_tt__v_prefilter_simd(pixels, w, h, stride_in_bytes, kernel_width);
+    pixels += j;
+#endif
+    for (; j < w; ++j)
     {
         int i;
         unsigned int total;
@@ -8529,6 +11013,7 @@ nk_tt_PackFontRangesGatherRects(struct nk_tt_pack_context *spc,
             nk_tt_ScaleForMappingEmToPixels(info, -fh);
         ranges[i].h_oversample = (unsigned char) spc->h_oversample;
         ranges[i].v_oversample = (unsigned char) spc->v_oversample;
+        ranges[i].sdf_spread = (unsigned char) spc->sdf_spread;
         for (j=0; j < ranges[i].num_chars; ++j) {
             int x0,y0,x1,y1;
             int codepoint = ranges[i].first_unicode_codepoint_in_range ?
@@ -8538,6 +11023,11 @@ nk_tt_PackFontRangesGatherRects(struct nk_tt_pack_context *spc,
             int glyph = nk_tt_FindGlyphIndex(info, codepoint);
             nk_tt_GetGlyphBitmapBoxSubpixel(info,glyph, scale * (float)spc->h_oversample,
                 scale * (float)spc->v_oversample, 0,0, &x0,&y0,&x1,&y1);
+            if (spc->sdf_spread && x1 > x0 && y1 > y0) {
+                /* distance field extends beyond the glyph outline */
+                x1 += 2 * (int)spc->sdf_spread;
+                y1 += 2 * (int)spc->sdf_spread;
+            }
             rects[k].w = (nk_rp_coord) (x1-x0 + spc->padding + (int)spc->h_oversample-1);
             rects[k].h = (nk_rp_coord) (y1-y0 + spc->padding + (int)spc->v_oversample-1);
             ++k;
@@ -8546,88 +11036,67 @@ nk_tt_PackFontRangesGatherRects(struct nk_tt_pack_context *spc,
     return k;
 }
 
-NK_INTERN int
-nk_tt_PackFontRangesRenderIntoRects(struct nk_tt_pack_context *spc,
-    struct nk_tt_fontinfo *info, struct nk_tt_pack_range *ranges,
-    int num_ranges, struct nk_rp_rect *rects, struct nk_allocator *alloc)
-{
-    int i,j,k, return_value = 1;
-    /* save current values */
-    int old_h_over = (int)spc->h_oversample;
-    int old_v_over = (int)spc->v_oversample;
-    /* rects array must be big enough to accommodate all characters in the given ranges */
-
-    k = 0;
-    for (i=0; i < num_ranges; ++i)
-    {
-        float fh = ranges[i].font_size;
-        float recip_h,recip_v,sub_x,sub_y;
-        float scale = fh > 0 ? nk_tt_ScaleForPixelHeight(info, fh):
-            nk_tt_ScaleForMappingEmToPixels(info, -fh);
-
-        spc->h_oversample = ranges[i].h_oversample;
-        spc->v_oversample = ranges[i].v_oversample;
-
-        recip_h = 1.0f / (float)spc->h_oversample;
-        recip_v = 1.0f / (float)spc->v_oversample;
-
-        sub_x = nk_tt__oversample_shift((int)spc->h_oversample);
-        sub_y = nk_tt__oversample_shift((int)spc->v_oversample);
-
-        for (j=0; j < ranges[i].num_chars; ++j)
-        {
-            struct nk_rp_rect *r = &rects[k];
-            if (r->was_packed)
-            {
-                struct nk_tt_packedchar *bc = &ranges[i].chardata_for_range[j];
-                int advance, lsb, x0,y0,x1,y1;
-                int codepoint = ranges[i].first_unicode_codepoint_in_range ?
-                    ranges[i].first_unicode_codepoint_in_range + j :
-                    ranges[i].array_of_unicode_codepoints[j];
-                int glyph = nk_tt_FindGlyphIndex(info, codepoint);
-                nk_rp_coord pad = (nk_rp_coord) spc->padding;
-
-                /* pad on left and top */
-                r->x = (nk_rp_coord)((int)r->x + (int)pad);
-                r->y = (nk_rp_coord)((int)r->y + (int)pad);
-                r->w = (nk_rp_coord)((int)r->w - (int)pad);
-                r->h = (nk_rp_coord)((int)r->h - (int)pad);
-
-                nk_tt_GetGlyphHMetrics(info, glyph, &advance, &lsb);
-                nk_tt_GetGlyphBitmapBox(info, glyph, scale * (float)spc->h_oversample,
-                        (scale * (float)spc->v_oversample), &x0,&y0,&x1,&y1);
-                nk_tt_MakeGlyphBitmapSubpixel(info, spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                    (int)(r->w - spc->h_oversample+1), (int)(r->h - spc->v_oversample+1),
-                    spc->stride_in_bytes, scale * (float)spc->h_oversample,
-                    scale * (float)spc->v_oversample, 0,0, glyph, alloc);
-
-                if (spc->h_oversample > 1)
-                   nk_tt__h_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                        r->w, r->h, spc->stride_in_bytes, (int)spc->h_oversample);
-
-                if (spc->v_oversample > 1)
-                   nk_tt__v_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                        r->w, r->h, spc->stride_in_bytes, (int)spc->v_oversample);
-
-                bc->x0       = (nk_ushort)  r->x;
-                bc->y0       = (nk_ushort)  r->y;
-                bc->x1       = (nk_ushort) (r->x + r->w);
-                bc->y1       = (nk_ushort) (r->y + r->h);
-                bc->xadvance = scale * (float)advance;
-                bc->xoff     = (float)  x0 * recip_h + sub_x;
-                bc->yoff     = (float)  y0 * recip_v + sub_y;
-                bc->xoff2    = ((float)x0 + r->w) * recip_h + sub_x;
-                bc->yoff2    = ((float)y0 + r->h) * recip_v + sub_y;
-            } else {
-                return_value = 0; /* if any fail, report failure */
-            }
-            ++k;
-        }
-    }
-    /* restore original values */
-    spc->h_oversample = (unsigned int)old_h_over;
-    spc->v_oversample = (unsigned int)old_v_over;
-    return return_value;
+NK_INTERN void
+nk_tt_PackGlyphRenderIntoRect(const struct nk_tt_pack_context *spc,
+    const struct nk_tt_fontinfo *info, struct nk_tt_pack_range *range,
+    int j, struct nk_rp_rect *r, struct nk_allocator *alloc)
+{
+    /* renders a single packed glyph. Only writes pixels inside its own rect
+     * so glyphs can be rendered concurrently */
+    struct nk_tt_packedchar *bc = &range->chardata_for_range[j];
+    int h_oversample = range->h_oversample;
+    int v_oversample = range->v_oversample;
+    float fh = range->font_size;
+    float scale = fh > 0 ? nk_tt_ScaleForPixelHeight(info, fh):
+        nk_tt_ScaleForMappingEmToPixels(info, -fh);
+    float recip_h = 1.0f / (float)h_oversample;
+    float recip_v = 1.0f / (float)v_oversample;
+    float sub_x = nk_tt__oversample_shift(h_oversample);
+    float sub_y = nk_tt__oversample_shift(v_oversample);
+    int advance, lsb, x0,y0,x1,y1;
+    int codepoint = range->first_unicode_codepoint_in_range ?
+        range->first_unicode_codepoint_in_range + j :
+        range->array_of_unicode_codepoints[j];
+    int glyph = nk_tt_FindGlyphIndex(info, codepoint);
+    nk_rp_coord pad = (nk_rp_coord) spc->padding;
+
+    /* pad on left and top */
+    r->x = (nk_rp_coord)((int)r->x + (int)pad);
+    r->y = (nk_rp_coord)((int)r->y + (int)pad);
+    r->w = (nk_rp_coord)((int)r->w - (int)pad);
+    r->h = (nk_rp_coord)((int)r->h - (int)pad);
+
+    nk_tt_GetGlyphHMetrics(info, glyph, &advance, &lsb);
+    nk_tt_GetGlyphBitmapBox(info, glyph, scale * (float)h_oversample,
+            (scale * (float)v_oversample), &x0,&y0,&x1,&y1);
+    if (range->sdf_spread && r->w > 0 && r->h > 0) {
+        x0 -= range->sdf_spread;
+        y0 -= range->sdf_spread;
+        nk_tt_MakeGlyphSDF(info, spc->pixels + r->x + r->y*spc->stride_in_bytes,
+            (int)r->w, (int)r->h, spc->stride_in_bytes, scale,
+            range->sdf_spread, glyph, alloc);
+    } else nk_tt_MakeGlyphBitmapSubpixel(info, spc->pixels + r->x + r->y*spc->stride_in_bytes,
+        (int)(r->w - h_oversample+1), (int)(r->h - v_oversample+1),
+        spc->stride_in_bytes, scale * (float)h_oversample,
+        scale * (float)v_oversample, 0,0, glyph, alloc);
+
+    if (h_oversample > 1)
+       nk_tt__h_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
+            r->w, r->h, spc->stride_in_bytes, h_oversample);
+
+    if (v_oversample > 1)
+       nk_tt__v_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
+            r->w, r->h, spc->stride_in_bytes, v_oversample);
+
+    bc->x0       = (nk_ushort)  r->x;
+    bc->y0       = (nk_ushort)  r->y;
+    bc->x1       = (nk_ushort) (r->x + r->w);
+    bc->y1       = (nk_ushort) (r->y + r->h);
+    bc->xadvance = scale * (float)advance;
+    bc->xoff     = (float)  x0 * recip_h + sub_x;
+    bc->yoff     = (float)  y0 * recip_v + sub_y;
+    bc->xoff2    = ((float)x0 + r->w) * recip_h + sub_x;
+    bc->yoff2    = ((float)y0 + r->h) * recip_v + sub_y;
 }
 
 NK_INTERN void
@@ -8679,10 +11148,16 @@ struct nk_font_baker {
     struct nk_font_bake_data *build;
     struct nk_tt_packedchar *packed_chars;
     struct nk_rp_rect *rects;
+    struct nk_rp_rect *pending;
+    struct nk_font_atlas_page *pages;
+    int page_count;
     struct nk_tt_pack_range *ranges;
 };
 
+NK_GLOBAL const int nk_bake_max_width = 1024 * 8;
+NK_GLOBAL const int nk_bake_max_height = 1024 * 32;
 NK_GLOBAL const nk_size nk_rect_align = NK_ALIGNOF(struct nk_rp_rect);
+NK_GLOBAL const nk_size nk_page_align = NK_ALIGNOF(struct nk_font_atlas_page);
 NK_GLOBAL const nk_size nk_range_align = NK_ALIGNOF(struct nk_tt_pack_range);
 NK_GLOBAL const nk_size nk_char_align = NK_ALIGNOF(struct nk_tt_packedchar);
 NK_GLOBAL const nk_size nk_build_align = NK_ALIGNOF(struct nk_font_bake_data);
@@ -8784,12 +11259,13 @@ nk_font_bake_memory(nk_size *temp, int *glyph_count,
         *glyph_count += nk_range_glyph_count(config[i].range, range_count);
     }
 
-    *temp = (nk_size)*glyph_count * sizeof(struct nk_rp_rect);
+    *temp = (nk_size)*glyph_count * sizeof(struct nk_rp_rect) * 2;
+    *temp += (nk_size)(*glyph_count + 1) * sizeof(struct nk_font_atlas_page);
     *temp += (nk_size)total_range_count * sizeof(struct nk_tt_pack_range);
     *temp += (nk_size)*glyph_count * sizeof(struct nk_tt_packedchar);
     *temp += (nk_size)count * sizeof(struct nk_font_bake_data);
     *temp += sizeof(struct nk_font_baker);
-    *temp += nk_rect_align + nk_range_align + nk_char_align;
+    *temp += nk_rect_align * 2 + nk_page_align + nk_range_align + nk_char_align;
     *temp += nk_build_align + nk_baker_align;
 }
 
@@ -8803,35 +11279,27 @@ nk_font_baker(void *memory, int glyph_count, int count, struct nk_allocator *all
     baker->build = (struct nk_font_bake_data*)NK_ALIGN_PTR((baker + 1), nk_build_align);
     baker->packed_chars = (struct nk_tt_packedchar*)NK_ALIGN_PTR((baker->build + count), nk_char_align);
     baker->rects = (struct nk_rp_rect*)NK_ALIGN_PTR((baker->packed_chars + glyph_count), nk_rect_align);
-    baker->ranges = (struct nk_tt_pack_range*)NK_ALIGN_PTR((baker->rects + glyph_count), nk_range_align);
+    baker->pending = (struct nk_rp_rect*)NK_ALIGN_PTR((baker->rects + glyph_count), nk_rect_align);
+    baker->pages = (struct nk_font_atlas_page*)NK_ALIGN_PTR((baker->pending + glyph_count), nk_page_align);
+    baker->ranges = (struct nk_tt_pack_range*)NK_ALIGN_PTR((baker->pages + glyph_count + 1), nk_range_align);
     baker->alloc = *alloc;
     return baker;
 }
 
-NK_API int
-nk_font_bake_pack(nk_size *image_memory, int *width, int *height,
-    struct nk_recti *custom, void *temp, nk_size temp_size,
-    const struct nk_font_config *config, int count,
-    struct nk_allocator *alloc)
+NK_INTERN int
+nk_font_bake_pack_pages(struct nk_recti *custom, void *temp, nk_size temp_size,
+    const struct nk_font_config *config, int count, int page_width,
+    int page_height, int max_pages, struct nk_allocator *alloc)
 {
-    NK_STORAGE const nk_size max_height = 1024 * 32;
+    /* packs all glyphs into `baker->pages` of at most `page_width` times
+     * `page_height` texels each. Every packed rect stores its page in `id`.
+     * Glyphs left over after `max_pages` pages (0: no limit) are not packed */
     struct nk_font_baker* baker;
     int total_glyph_count = 0;
     int total_range_count = 0;
     int range_count = 0;
     int i = 0;
 
-    NK_ASSERT(image_memory);
-    NK_ASSERT(width);
-    NK_ASSERT(height);
-    NK_ASSERT(config);
-    NK_ASSERT(temp);
-    NK_ASSERT(temp_size);
-    NK_ASSERT(count);
-    NK_ASSERT(alloc);
-    if (!image_memory || !width || !height || !config || !temp ||
-        !temp_size || !count) return nk_false;
-
     for (i = 0; i < count; ++i) {
         range_count = nk_range_count(config[i].range);
         total_range_count += range_count;
@@ -8848,33 +11316,18 @@ nk_font_bake_pack(nk_size *image_memory, int *width, int *height,
             return nk_false;
     }
 
-    *height = 0;
-    *width = (total_glyph_count > 1000) ? 1024 : 512;
-    nk_tt_PackBegin(&baker->spc, 0, (int)*width, (int)max_height, 0, 1, alloc);
+    /* glyph size pass: gather the size of all glyphs */
+    if (!nk_tt_PackBegin(&baker->spc, 0, page_width, page_height, 0, 1, alloc))
+        return nk_false;
     {
         int input_i = 0;
         int range_n = 0;
         int rect_n = 0;
         int char_n = 0;
+        int remaining = 0;
+        nk_size area = 0;
+        struct nk_rp_context *context = (struct nk_rp_context*)baker->spc.pack_info;
 
-        /* pack custom user data first so it will be in the upper left corner*/
-        if (custom) {
-            struct nk_rp_rect custom_space;
-            nk_zero(&custom_space, sizeof(custom_space));
-            custom_space.w = (nk_rp_coord)((custom->w * 2) + 1);
-            custom_space.h = (nk_rp_coord)(custom->h + 1);
-
-            nk_tt_PackSetOversampling(&baker->spc, 1, 1);
-            nk_rp_pack_rects((struct nk_rp_context*)baker->spc.pack_info, &custom_space, 1);
-            *height = NK_MAX(*height, (int)(custom_space.y + custom_space.h));
-
-            custom->x = (short)custom_space.x;
-            custom->y = (short)custom_space.y;
-            custom->w = (short)custom_space.w;
-            custom->h = (short)custom_space.h;
-        }
-
-        /* first font pass: pack all glyphs */
         for (input_i = 0; input_i < count; input_i++) {
             int n = 0;
             const nk_rune *in_range;
@@ -8902,61 +11355,226 @@ nk_font_bake_pack(nk_size *image_memory, int *width, int *height,
                 char_n += tmp->ranges[i].num_chars;
             }
 
-            /* pack */
+            /* gather */
             tmp->rects = baker->rects + rect_n;
             rect_n += glyph_count;
-            nk_tt_PackSetOversampling(&baker->spc, cfg->oversample_h, cfg->oversample_v);
+            if (cfg->sdf_spread)
+                nk_tt_PackSetOversampling(&baker->spc, 1, 1);
+            else nk_tt_PackSetOversampling(&baker->spc, cfg->oversample_h, cfg->oversample_v);
+            baker->spc.sdf_spread = cfg->sdf_spread;
             n = nk_tt_PackFontRangesGatherRects(&baker->spc, &tmp->info,
                 tmp->ranges, (int)tmp->range_count, tmp->rects);
-            nk_rp_pack_rects((struct nk_rp_context*)baker->spc.pack_info, tmp->rects, (int)n);
-
-            /* texture height */
             for (i = 0; i < n; ++i) {
-                if (tmp->rects[i].was_packed)
-                    *height = NK_MAX(*height, tmp->rects[i].y + tmp->rects[i].h);
+                area += (nk_size)tmp->rects[i].w * (nk_size)tmp->rects[i].h;
+                tmp->rects[i].id = -1;
             }
+            remaining += n;
         }
         NK_ASSERT(rect_n == total_glyph_count);
         NK_ASSERT(char_n == total_glyph_count);
         NK_ASSERT(range_n == total_range_count);
+
+        /* pack pass: each page packs all glyphs not fitting any previous page */
+        baker->page_count = 0;
+        do {
+            struct nk_font_atlas_page *page = &baker->pages[baker->page_count];
+            nk_size page_area = area;
+            int packed = 0, full = 0;
+            int side = 64;
+
+            /* start with the smallest square texture holding all remaining
+             * glyphs which doubles its smaller side whenever they do not fit */
+            if (custom && !baker->page_count)
+                page_area += (nk_size)((custom->w * 2) + 1) * (nk_size)(custom->h + 1);
+            while (side < page_width && (nk_size)side * (nk_size)side < page_area)
+                side *= 2;
+            nk_rp_init_target(context, NK_MIN(side, page_width), NK_MIN(side, page_height),
+                (struct nk_rp_node*)baker->spc.nodes, page_width - 1);
+            nk_rp_setup_heuristic(context, NK_RP_HEURISTIC_Skyline_BF_sortHeight);
+            nk_rp_setup_growth(context, page_width, page_height);
+
+            /* pack custom user data first so it will be in the upper left corner*/
+            if (custom && !baker->page_count) {
+                struct nk_rp_rect custom_space;
+                nk_zero(&custom_space, sizeof(custom_space));
+                custom_space.w = (nk_rp_coord)((custom->w * 2) + 1);
+                custom_space.h = (nk_rp_coord)(custom->h + 1);
+                nk_rp_pack_rects(context, &custom_space, 1);
+
+                custom->x = (short)custom_space.x;
+                custom->y = (short)custom_space.y;
+                custom->w = (short)custom_space.w;
+                custom->h = (short)custom_space.h;
+            }
+
+            /* pack all glyphs of each font without a page yet. Multiple pages
+             * are filled in codepoint order in chunks of 256 glyphs and closed
+             * at the first miss so neighbouring codepoints share a page */
+            for (input_i = 0; input_i < count && !full; input_i++) {
+                struct nk_font_bake_data *tmp = &baker->build[input_i];
+                int glyph_count = 0, chunk, g = 0, n;
+                for (i = 0; i < (int)tmp->range_count; ++i)
+                    glyph_count += tmp->ranges[i].num_chars;
+                chunk = (max_pages == 1) ? glyph_count: 256;
+                while (g < glyph_count && !full) {
+                    for (n = 0; g < glyph_count && n < chunk; ++g) {
+                        if (tmp->rects[g].id >= 0) continue;
+                        baker->pending[n] = tmp->rects[g];
+                        baker->pending[n++].id = g;
+                    }
+                    nk_rp_pack_rects(context, baker->pending, n);
+                    for (i = 0; i < n; ++i) {
+                        struct nk_rp_rect *r = &baker->pending[i];
+                        if (!r->was_packed) {
+                            full = (max_pages != 1);
+                            continue;
+                        }
+                        area -= (nk_size)r->w * (nk_size)r->h;
+                        tmp->rects[r->id] = *r;
+                        tmp->rects[r->id].id = baker->page_count;
+                        packed++;
+                    }
+                }
+            }
+            /* glyphs larger than a page would never fit */
+            if (!packed && baker->page_count) break;
+            page->width = context->width;
+            page->height = NK_MIN((int)nk_round_up_pow2((nk_uint)context->bottom), page_height);
+            remaining -= packed;
+            baker->page_count++;
+        } while (remaining && (!max_pages || baker->page_count < max_pages));
     }
-    *height = (int)nk_round_up_pow2((nk_uint)*height);
-    *image_memory = (nk_size)(*width) * (nk_size)(*height);
     return nk_true;
 }
 
-NK_API void
-nk_font_bake(void *image_memory, int width, int height,
-    void *temp, nk_size temp_size, struct nk_font_glyph *glyphs,
-    int glyphs_count, const struct nk_font_config *config, int font_count)
+NK_API int
+nk_font_bake_pack(nk_size *image_memory, int *width, int *height,
+    struct nk_recti *custom, void *temp, nk_size temp_size,
+    const struct nk_font_config *config, int count,
+    struct nk_allocator *alloc)
 {
-    int input_i = 0;
     struct nk_font_baker* baker;
-    nk_rune glyph_n = 0;
-
     NK_ASSERT(image_memory);
     NK_ASSERT(width);
     NK_ASSERT(height);
     NK_ASSERT(config);
     NK_ASSERT(temp);
     NK_ASSERT(temp_size);
-    NK_ASSERT(font_count);
-    NK_ASSERT(glyphs_count);
+    NK_ASSERT(count);
+    NK_ASSERT(alloc);
     if (!image_memory || !width || !height || !config || !temp ||
-        !temp_size || !font_count || !glyphs || !glyphs_count)
-        return;
+        !temp_size || !count) return nk_false;
 
-    /* second font pass: render glyphs */
+    if (!nk_font_bake_pack_pages(custom, temp, temp_size, config, count,
+        nk_bake_max_width, nk_bake_max_height, 1, alloc))
+        return nk_false;
     baker = (struct nk_font_baker*)NK_ALIGN_PTR(temp, nk_baker_align);
-    nk_zero(image_memory, (nk_size)((nk_size)width * (nk_size)height));
-    baker->spc.pixels = (unsigned char*)image_memory;
-    baker->spc.height = (int)height;
-    for (input_i = 0; input_i < font_count; ++input_i) {
-        const struct nk_font_config *cfg = &config[input_i];
-        struct nk_font_bake_data *tmp = &baker->build[input_i];
-        nk_tt_PackSetOversampling(&baker->spc, cfg->oversample_h, cfg->oversample_v);
-        nk_tt_PackFontRangesRenderIntoRects(&baker->spc, &tmp->info, tmp->ranges,
-            (int)tmp->range_count, tmp->rects, &baker->alloc);
+    *width = baker->pages[0].width;
+    *height = baker->pages[0].height;
+    *image_memory = (nk_size)(*width) * (nk_size)(*height);
+    return nk_true;
+}
+
+NK_API void
+nk_font_bake_job_run(struct nk_font_bake_job *job)
+{
+    int i, j, k = 0, page = -1;
+    struct nk_font_baker *baker;
+    struct nk_font_bake_data *tmp;
+    struct nk_tt_pack_context spc;
+    NK_ASSERT(job);
+    NK_ASSERT(job->baker);
+    if (!job || !job->baker) return;
+
+    baker = (struct nk_font_baker*)job->baker;
+    tmp = &baker->build[job->font];
+    spc = baker->spc;
+    for (i = 0; i < (int)tmp->range_count && k < job->begin + job->count; ++i) {
+        struct nk_tt_pack_range *range = &tmp->ranges[i];
+        if (k + range->num_chars <= job->begin) {
+            k += range->num_chars;
+            continue;
+        }
+        for (j = 0; j < range->num_chars; ++j, ++k) {
+            if (k < job->begin || k >= job->begin + job->count) continue;
+            if (!tmp->rects[k].was_packed) continue;
+            if (tmp->rects[k].id != page) {
+                /* render into the image of the glyph's page */
+                page = tmp->rects[k].id;
+                spc.pixels = (unsigned char*)baker->pages[page].pixel;
+                spc.width = spc.stride_in_bytes = baker->pages[page].width;
+                spc.height = baker->pages[page].height;
+            }
+            nk_tt_PackGlyphRenderIntoRect(&spc, &tmp->info, range, j,
+                &tmp->rects[k], &job->alloc);
+        }
+    }
+}
+
+NK_INTERN int
+nk_font_bake_dispatch(struct nk_font_baker *baker, int font_count,
+    const struct nk_font_bake_dispatcher *dispatcher)
+{
+    /* splits all packed glyphs into jobs of at most `glyphs_per_job` glyphs
+     * and returns 0 without rendering anything if the jobs can't be allocated */
+    int i, n, job_count = 0;
+    int per_job = (dispatcher->glyphs_per_job) ? (int)dispatcher->glyphs_per_job: 256;
+    struct nk_font_bake_job *jobs;
+    for (i = 0; i < font_count; ++i) {
+        const struct nk_font_bake_data *tmp = &baker->build[i];
+        int glyphs = 0;
+        for (n = 0; n < (int)tmp->range_count; ++n)
+            glyphs += tmp->ranges[n].num_chars;
+        job_count += (glyphs + per_job - 1) / per_job;
+    }
+    if (!job_count) return 1;
+
+    jobs = (struct nk_font_bake_job*)dispatcher->alloc.alloc(dispatcher->alloc.userdata,
+        0, sizeof(struct nk_font_bake_job) * (nk_size)job_count);
+    if (!jobs) return 0;
+    for (i = 0, n = 0; i < font_count; ++i) {
+        const struct nk_font_bake_data *tmp = &baker->build[i];
+        int r, begin, glyphs = 0;
+        for (r = 0; r < (int)tmp->range_count; ++r)
+            glyphs += tmp->ranges[r].num_chars;
+        for (begin = 0; begin < glyphs; begin += per_job, ++n) {
+            jobs[n].alloc = dispatcher->alloc;
+            jobs[n].baker = baker;
+            jobs[n].font = i;
+            jobs[n].begin = begin;
+            jobs[n].count = NK_MIN(per_job, glyphs - begin);
+        }
+    }
+    dispatcher->dispatch(dispatcher->userdata, jobs, job_count);
+    dispatcher->alloc.free(dispatcher->alloc.userdata, jobs);
+    return 1;
+}
+
+NK_INTERN void
+nk_font_bake_render(struct nk_font_baker *baker, struct nk_font_glyph *glyphs,
+    const struct nk_font_config *config, int font_count,
+    const struct nk_font_bake_dispatcher *dispatcher)
+{
+    /* renders all packed glyphs into the zeroed images of `baker->pages` */
+    int input_i = 0;
+    nk_rune glyph_n = 0;
+
+    /* second font pass: render glyphs, serially if there is no dispatcher
+     * or it failed to allocate its jobs */
+    if (!dispatcher || !dispatcher->dispatch || !dispatcher->alloc.alloc ||
+        !nk_font_bake_dispatch(baker, font_count, dispatcher)) {
+        for (input_i = 0; input_i < font_count; ++input_i) {
+            struct nk_font_bake_data *tmp = &baker->build[input_i];
+            struct nk_font_bake_job job;
+            int i;
+            job.alloc = baker->alloc;
+            job.baker = baker;
+            job.font = input_i;
+            job.begin = job.count = 0;
+            for (i = 0; i < (int)tmp->range_count; ++i)
+                job.count += tmp->ranges[i].num_chars;
+            nk_font_bake_job_run(&job);
+        }
     }
     nk_tt_PackEnd(&baker->spc, &baker->alloc);
 
@@ -8965,6 +11583,7 @@ nk_font_bake(void *image_memory, int width, int height,
     {
         nk_size i = 0;
         int char_idx = 0;
+        int rect_n = 0;
         nk_rune glyph_count = 0;
         const struct nk_font_config *cfg = &config[input_i];
         struct nk_font_bake_data *tmp = &baker->build[input_i];
@@ -8981,6 +11600,7 @@ nk_font_bake(void *image_memory, int width, int height,
             dst_font->height = cfg->size;
             dst_font->ascent = ((float)unscaled_ascent * font_scale);
             dst_font->descent = ((float)unscaled_descent * font_scale);
+            dst_font->sdf_spread = (float)cfg->sdf_spread;
             dst_font->glyph_offset = glyph_n;
         }
 
@@ -8988,20 +11608,25 @@ nk_font_bake(void *image_memory, int width, int height,
         for (i = 0; i < tmp->range_count; ++i)
         {
             struct nk_tt_pack_range *range = &tmp->ranges[i];
-            for (char_idx = 0; char_idx < range->num_chars; char_idx++)
+            for (char_idx = 0; char_idx < range->num_chars; char_idx++, rect_n++)
             {
                 nk_rune codepoint = 0;
                 float dummy_x = 0, dummy_y = 0;
                 struct nk_tt_aligned_quad q;
                 struct nk_font_glyph *glyph;
+                const struct nk_font_atlas_page *page;
+                int width, height;
 
                 /* query glyph bounds from stb_truetype */
                 const struct nk_tt_packedchar *pc = &range->chardata_for_range[char_idx];
                 glyph_count++;
                 if (!pc->x0 && !pc->x1 && !pc->y0 && !pc->y1) continue;
+                page = &baker->pages[tmp->rects[rect_n].id];
+                width = page->width;
+                height = page->height;
                 codepoint = (nk_rune)(range->first_unicode_codepoint_in_range + char_idx);
-                nk_tt_GetPackedQuad(range->chardata_for_range, (int)width,
-                    (int)height, char_idx, &dummy_x, &dummy_y, &q, 0);
+                nk_tt_GetPackedQuad(range->chardata_for_range, width,
+                    height, char_idx, &dummy_x, &dummy_y, &q, 0);
 
                 /* fill own glyph type with data */
                 glyph = &glyphs[dst_font->glyph_offset + (unsigned int)char_idx];
@@ -9024,6 +11649,7 @@ nk_font_bake(void *image_memory, int width, int height,
                     glyph->u1 = q.s1;
                     glyph->v1 = q.t1;
                 }
+                glyph->page = tmp->rects[rect_n].id;
                 glyph->xadvance = (pc->xadvance + cfg->spacing.x);
                 if (cfg->pixel_snap)
                     glyph->xadvance = (float)(int)(glyph->xadvance + 0.5f);
@@ -9034,6 +11660,42 @@ nk_font_bake(void *image_memory, int width, int height,
     }
 }
 
+NK_API void
+nk_font_bake(void *image_memory, int width, int height,
+    void *temp, nk_size temp_size, struct nk_font_glyph *glyphs,
+    int glyphs_count, const struct nk_font_config *config, int font_count)
+{
+    nk_font_bake_parallel(image_memory, width, height, temp, temp_size,
+        glyphs, glyphs_count, config, font_count, 0);
+}
+
+NK_API void
+nk_font_bake_parallel(void *image_memory, int width, int height,
+    void *temp, nk_size temp_size, struct nk_font_glyph *glyphs,
+    int glyphs_count, const struct nk_font_config *config, int font_count,
+    const struct nk_font_bake_dispatcher *dispatcher)
+{
+    struct nk_font_baker* baker;
+    NK_ASSERT(image_memory);
+    NK_ASSERT(width);
+    NK_ASSERT(height);
+    NK_ASSERT(config);
+    NK_ASSERT(temp);
+    NK_ASSERT(temp_size);
+    NK_ASSERT(font_count);
+    NK_ASSERT(glyphs_count);
+    if (!image_memory || !width || !height || !config || !temp ||
+        !temp_size || !font_count || !glyphs || !glyphs_count)
+        return;
+
+    baker = (struct nk_font_baker*)NK_ALIGN_PTR(temp, nk_baker_align);
+    nk_zero(image_memory, (nk_size)((nk_size)width * (nk_size)height));
+    baker->pages[0].pixel = image_memory;
+    baker->pages[0].width = width;
+    baker->pages[0].height = height;
+    nk_font_bake_render(baker, glyphs, config, font_count, dispatcher);
+}
+
 NK_API void
 nk_font_bake_custom_data(void *img_memory, int img_width, int img_height,
     struct nk_recti img_dst, const char *texture_data_mask, int tex_width,
@@ -9083,19 +11745,495 @@ nk_font_bake_convert(void *out_memory, int img_width, int img_height,
         *dst++ = ((nk_rune)(*src++) << 24) | 0x00FFFFFF;
 }
 
+/* -------------------------------------------------------------
+ *
+ *                          FONT CACHE
+ *
+ * --------------------------------------------------------------*/
+struct nk_font_cache_shelf {
+    int y, height;
+    int x; /* first free column */
+    nk_uint frame; /* last frame a glyph on this shelf was used */
+};
+
+struct nk_font_cache_entry {
+    nk_uint key; /* (config << 21) | codepoint */
+    int shelf; /* shelf holding the glyph pixels or -1 if unused */
+};
+
+struct nk_font_cache {
+    void *memory; /* allocated memory block holding the cache */
+    const struct nk_font_config *config;
+    struct nk_tt_fontinfo *info;
+    int config_count;
+    struct nk_allocator alloc;
+
+    void *pixel;
+    int width, height;
+    enum nk_font_atlas_format format;
+    struct nk_recti dirty;
+    int is_dirty;
+    nk_uint frame;
+
+    struct nk_font_glyph *glyphs;
+    struct nk_font_cache_entry *entries;
+    int *free_slots;
+    int free_count;
+    int glyph_capacity;
+
+    int *table; /* glyph slot plus one for each bucket (0: empty) */
+    nk_uint table_capacity;
+
+    struct nk_font_cache_shelf *shelves;
+    int shelf_count;
+    int shelf_capacity;
+    int top; /* first row not used by any shelf */
+
+    struct nk_font_glyph empty;
+    struct nk_font_glyph overflow;
+};
+
+NK_GLOBAL const nk_size nk_cache_align = NK_ALIGNOF(struct nk_font_cache);
+NK_GLOBAL const nk_size nk_info_align = NK_ALIGNOF(struct nk_tt_fontinfo);
+NK_GLOBAL const nk_size nk_glyph_align = NK_ALIGNOF(struct nk_font_glyph);
+NK_GLOBAL const nk_size nk_entry_align = NK_ALIGNOF(struct nk_font_cache_entry);
+NK_GLOBAL const nk_size nk_shelf_align = NK_ALIGNOF(struct nk_font_cache_shelf);
+
+NK_INTERN nk_size
+nk_font_cache_memory(int config_count, int glyph_capacity,
+    nk_uint table_capacity, int shelf_capacity)
+{
+    nk_size size = sizeof(struct nk_font_cache);
+    size += (nk_size)config_count * sizeof(struct nk_tt_fontinfo);
+    size += (nk_size)glyph_capacity * sizeof(struct nk_font_glyph);
+    size += (nk_size)glyph_capacity * sizeof(struct nk_font_cache_entry);
+    size += (nk_size)glyph_capacity * sizeof(int);
+    size += (nk_size)table_capacity * sizeof(int);
+    size += (nk_size)shelf_capacity * sizeof(struct nk_font_cache_shelf);
+    size += nk_cache_align + nk_info_align + nk_glyph_align;
+    size += nk_entry_align + nk_shelf_align;
+    return size;
+}
+
+NK_INTERN struct nk_font_cache*
+nk_font_cache(void *memory, int config_count, int glyph_capacity,
+    nk_uint table_capacity, int shelf_capacity)
+{
+    /* setup cache inside a memory block of `nk_font_cache_memory` bytes */
+    int i;
+    struct nk_font_cache *cache;
+    cache = (struct nk_font_cache*)NK_ALIGN_PTR(memory, nk_cache_align);
+    nk_zero(cache, sizeof(*cache));
+    cache->info = (struct nk_tt_fontinfo*)NK_ALIGN_PTR((cache + 1), nk_info_align);
+    cache->glyphs = (struct nk_font_glyph*)NK_ALIGN_PTR((cache->info + config_count), nk_glyph_align);
+    cache->entries = (struct nk_font_cache_entry*)NK_ALIGN_PTR((cache->glyphs + glyph_capacity), nk_entry_align);
+    cache->shelves = (struct nk_font_cache_shelf*)NK_ALIGN_PTR((cache->entries + glyph_capacity), nk_shelf_align);
+    cache->free_slots = (int*)(void*)(cache->shelves + shelf_capacity);
+    cache->table = cache->free_slots + glyph_capacity;
+    nk_zero(cache->table, (nk_size)table_capacity * sizeof(int));
+
+    cache->config_count = config_count;
+    cache->glyph_capacity = glyph_capacity;
+    cache->table_capacity = table_capacity;
+    cache->shelf_capacity = shelf_capacity;
+    for (i = 0; i < glyph_capacity; ++i) {
+        cache->entries[i].shelf = -1;
+        cache->free_slots[i] = glyph_capacity - i - 1;
+    }
+    cache->free_count = glyph_capacity;
+    cache->frame = 1;
+    return cache;
+}
+
+NK_INTERN struct nk_recti
+nk_font_cache_rect(int x, int y, int w, int h)
+{
+    struct nk_recti r;
+    r.x = (short)x;
+    r.y = (short)y;
+    r.w = (short)w;
+    r.h = (short)h;
+    return r;
+}
+
+NK_INTERN nk_uint
+nk_font_cache_hash(nk_uint key)
+{
+    key *= 2654435761u;
+    return key ^ (key >> 16);
+}
+
+NK_INTERN int
+nk_font_cache_lookup(const struct nk_font_cache *cache, nk_uint key)
+{
+    nk_uint mask = cache->table_capacity - 1;
+    nk_uint i = nk_font_cache_hash(key) & mask;
+    while (cache->table[i]) {
+        int slot = cache->table[i] - 1;
+        if (cache->entries[slot].key == key)
+            return slot;
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+NK_INTERN void
+nk_font_cache_insert(struct nk_font_cache *cache, int slot)
+{
+    nk_uint mask = cache->table_capacity - 1;
+    nk_uint i = nk_font_cache_hash(cache->entries[slot].key) & mask;
+    while (cache->table[i])
+        i = (i + 1) & mask;
+    cache->table[i] = slot + 1;
+}
+
+NK_INTERN void
+nk_font_cache_remove(struct nk_font_cache *cache, int slot)
+{
+    /* backward shift deletion like the window map */
+    nk_uint mask = cache->table_capacity - 1;
+    nk_uint i = nk_font_cache_hash(cache->entries[slot].key) & mask;
+    nk_uint j;
+    while (cache->table[i] != slot + 1) {
+        NK_ASSERT(cache->table[i]);
+        if (!cache->table[i]) return;
+        i = (i + 1) & mask;
+    }
+    j = i;
+    while (1) {
+        nk_uint home;
+        j = (j + 1) & mask;
+        if (!cache->table[j]) break;
+        home = nk_font_cache_hash(cache->entries[cache->table[j]-1].key) & mask;
+        if ((i <= j) ? (home <= i || home > j): (home <= i && home > j)) {
+            cache->table[i] = cache->table[j];
+            i = j;
+        }
+    }
+    cache->table[i] = 0;
+}
+
+NK_INTERN void
+nk_font_cache_blit(struct nk_font_cache *cache, const nk_byte *alpha,
+    int x, int y, int w, int h)
+{
+    /* copies an alpha8 image into the page or clears the area if `alpha` is 0
+     * and adds it to the dirty rectangle */
+    int i, j;
+    if (w <= 0 || h <= 0) return;
+    for (j = 0; j < h; ++j) {
+        const nk_byte *src = (alpha) ? alpha + j * w: 0;
+        nk_size offset = (nk_size)(y + j) * (nk_size)cache->width + (nk_size)x;
+        if (cache->format == NK_FONT_ATLAS_RGBA32) {
+            nk_rune *dst = (nk_rune*)cache->pixel + offset;
+            for (i = 0; i < w; ++i)
+                dst[i] = ((nk_rune)((src) ? src[i]: 0) << 24) | 0x00FFFFFF;
+        } else if (src) {
+            NK_MEMCPY((nk_byte*)cache->pixel + offset, src, (nk_size)w);
+        } else NK_MEMSET((nk_byte*)cache->pixel + offset, 0, (nk_size)w);
+    }
+
+    if (!cache->is_dirty) {
+        cache->dirty = nk_font_cache_rect(x, y, w, h);
+        cache->is_dirty = nk_true;
+    } else {
+        int x0 = NK_MIN(cache->dirty.x, x);
+        int y0 = NK_MIN(cache->dirty.y, y);
+        int x1 = NK_MAX(cache->dirty.x + cache->dirty.w, x + w);
+        int y1 = NK_MAX(cache->dirty.y + cache->dirty.h, y + h);
+        cache->dirty = nk_font_cache_rect(x0, y0, x1 - x0, y1 - y0);
+    }
+}
+
+NK_INTERN void
+nk_font_cache_evict(struct nk_font_cache *cache, int shelf)
+{
+    /* drops every glyph on the shelf and clears its pixels */
+    int i;
+    struct nk_font_cache_shelf *s = &cache->shelves[shelf];
+    for (i = 0; i < cache->glyph_capacity; ++i) {
+        if (cache->entries[i].shelf != shelf) continue;
+        nk_font_cache_remove(cache, i);
+        cache->entries[i].shelf = -1;
+        cache->free_slots[cache->free_count++] = i;
+    }
+    nk_font_cache_blit(cache, 0, 0, s->y, s->x, s->height);
+    s->x = 0;
+}
+
+NK_INTERN int
+nk_font_cache_lru(const struct nk_font_cache *cache, int height)
+{
+    /* least recently used shelf of at least `height` rows. Shelves used in
+     * the current frame are never returned since their glyphs may already
+     * be referenced by vertices that have not been drawn yet */
+    int i, lru = -1;
+    for (i = 0; i < cache->shelf_count; ++i) {
+        const struct nk_font_cache_shelf *s = &cache->shelves[i];
+        if (s->frame == cache->frame || s->height < height || !s->x) continue;
+        if (lru < 0 || s->frame < cache->shelves[lru].frame)
+            lru = i;
+    }
+    return lru;
+}
+
+NK_INTERN int
+nk_font_cache_pack(struct nk_font_cache *cache, int w, int h, int *x, int *y)
+{
+    /* finds space for a `w` x `h` rectangle inside a shelf and returns the
+     * shelf or -1 if the page is full of glyphs used in the current frame */
+    int i, best = -1;
+    int height = (h + 3) & ~3;
+    struct nk_font_cache_shelf *s;
+    if (w > cache->width || h > cache->height - 1) return -1;
+
+    /* best fitting shelf without wasting too many rows */
+    for (i = 0; i < cache->shelf_count; ++i) {
+        s = &cache->shelves[i];
+        if (s->height < h || s->height > height * 2 || cache->width - s->x < w) continue;
+        if (best < 0 || s->height < cache->shelves[best].height) best = i;
+    }
+    /* open a new shelf below all others */
+    if (best < 0 && cache->top + height <= cache->height &&
+        cache->shelf_count < cache->shelf_capacity) {
+        best = cache->shelf_count++;
+        s = &cache->shelves[best];
+        s->y = cache->top;
+        s->height = height;
+        s->x = 0;
+        cache->top += height;
+    }
+    /* any shelf with enough space */
+    for (i = 0; best < 0 && i < cache->shelf_count; ++i) {
+        s = &cache->shelves[i];
+        if (s->height >= h && cache->width - s->x >= w) best = i;
+    }
+    /* evict the least recently used shelf */
+    if (best < 0) {
+        best = nk_font_cache_lru(cache, h);
+        if (best < 0) return -1;
+        nk_font_cache_evict(cache, best);
+    }
+    s = &cache->shelves[best];
+    *x = s->x;
+    *y = s->y;
+    s->x += w;
+    s->frame = cache->frame;
+    return best;
+}
+
+NK_INTERN int
+nk_font_cache_config(const struct nk_font_cache *cache, int config, nk_rune unicode)
+{
+    /* first config of a font (including merged fonts) covering the codepoint */
+    int i = config;
+    do {
+        const nk_rune *range;
+        for (range = cache->config[i].range; range[0] && range[1]; range += 2) {
+            if (unicode >= range[0] && unicode <= range[1])
+                return i;
+        }
+        ++i;
+    } while (i < cache->config_count && cache->config[i].merge_mode);
+    return -1;
+}
+
+NK_INTERN int
+nk_font_cache_add(struct nk_font_cache *cache, int config, nk_uint key,
+    nk_rune codepoint, float ascent)
+{
+    /* rasterizes a glyph into the page and returns its slot. If there is no
+     * space left the glyph metrics are stored in the overflow glyph */
+    const struct nk_font_config *cfg = &cache->config[config];
+    struct nk_tt_fontinfo *info = &cache->info[config];
+    struct nk_font_glyph *glyph = &cache->overflow;
+    int spread = cfg->sdf_spread;
+    int h_over = (spread) ? 1: NK_MAX(cfg->oversample_h, 1);
+    int v_over = (spread) ? 1: NK_MAX(cfg->oversample_v, 1);
+    int index, advance, lsb, x0, y0, x1, y1, w, h;
+    int slot = -1, shelf = -1, x = 0, y = 0;
+    float scale;
+
+    scale = nk_tt_ScaleForPixelHeight(info, cfg->size);
+    index = nk_tt_FindGlyphIndex(info, (int)codepoint);
+    nk_tt_GetGlyphHMetrics(info, index, &advance, &lsb);
+    nk_tt_GetGlyphBitmapBoxSubpixel(info, index, scale * (float)h_over,
+        scale * (float)v_over, 0, 0, &x0, &y0, &x1, &y1);
+    if (spread && x1 > x0 && y1 > y0) {
+        /* distance field extends beyond the glyph outline */
+        x0 -= spread; y0 -= spread;
+        x1 += spread; y1 += spread;
+    } else spread = 0;
+    w = x1 - x0 + h_over - 1;
+    h = y1 - y0 + v_over - 1;
+
+    /* find a free slot and space with one pixel padding to the top left */
+    if (!cache->free_count) {
+        int lru = nk_font_cache_lru(cache, 0);
+        if (lru >= 0) nk_font_cache_evict(cache, lru);
+    }
+    if (cache->free_count)
+        shelf = nk_font_cache_pack(cache, w + 1, h + 1, &x, &y);
+    if (shelf >= 0) {
+        slot = cache->free_slots[--cache->free_count];
+        cache->entries[slot].key = key;
+        cache->entries[slot].shelf = shelf;
+        nk_font_cache_insert(cache, slot);
+        glyph = &cache->glyphs[slot];
+
+        /* rasterize into temporary memory and copy into the page */
+        {nk_size size = (nk_size)(w + 1) * (nk_size)(h + 1);
+        nk_byte *pixels = (nk_byte*)cache->alloc.alloc(cache->alloc.userdata, 0, size);
+        if (pixels) {
+            nk_byte *dst = pixels + (w + 1) + 1;
+            nk_zero(pixels, size);
+            if (spread) {
+                nk_tt_MakeGlyphSDF(info, dst, w, h, w + 1, scale, spread, index,
+                    &cache->alloc);
+            } else if (w > 0 && h > 0) {
+                nk_tt_MakeGlyphBitmapSubpixel(info, dst, w - h_over + 1, h - v_over + 1,
+                    w + 1, scale * (float)h_over, scale * (float)v_over, 0, 0, index,
+                    &cache->alloc);
+                if (h_over > 1) nk_tt__h_prefilter(dst, w, h, w + 1, h_over);
+                if (v_over > 1) nk_tt__v_prefilter(dst, w, h, w + 1, v_over);
+            }
+            nk_font_cache_blit(cache, pixels, x, y, w + 1, h + 1);
+            cache->alloc.free(cache->alloc.userdata, pixels);
+        }}
+        x += 1; y += 1;
+    }
+
+    /* fill glyph the same way as `nk_font_bake` */
+    {float recip_h = 1.0f / (float)h_over;
+    float recip_v = 1.0f / (float)v_over;
+    float sub_x = nk_tt__oversample_shift(h_over);
+    float sub_y = nk_tt__oversample_shift(v_over);
+    glyph->codepoint = codepoint;
+    glyph->x0 = (float)x0 * recip_h + sub_x;
+    glyph->y0 = (float)y0 * recip_v + sub_y + (ascent + 0.5f);
+    glyph->x1 = ((float)x0 + (float)w) * recip_h + sub_x;
+    glyph->y1 = ((float)y0 + (float)h) * recip_v + sub_y + (ascent + 0.5f);
+    if (slot < 0) {
+        /* no space left so the glyph is measured but not drawn */
+        glyph->x1 = glyph->x0;
+        glyph->y1 = glyph->y0;
+        x = y = w = h = 0;
+    }
+    glyph->w = glyph->x1 - glyph->x0 + 0.5f;
+    glyph->h = glyph->y1 - glyph->y0;
+    if (cfg->coord_type == NK_COORD_PIXEL) {
+        glyph->u0 = (float)x;
+        glyph->v0 = (float)y;
+        glyph->u1 = (float)(x + w);
+        glyph->v1 = (float)(y + h);
+    } else {
+        glyph->u0 = (float)x / (float)cache->width;
+        glyph->v0 = (float)y / (float)cache->height;
+        glyph->u1 = (float)(x + w) / (float)cache->width;
+        glyph->v1 = (float)(y + h) / (float)cache->height;
+    }
+    glyph->page = 0;
+    glyph->xadvance = scale * (float)advance + cfg->spacing.x;
+    if (cfg->pixel_snap)
+        glyph->xadvance = (float)(int)(glyph->xadvance + 0.5f);}
+    return slot;
+}
+
+NK_INTERN const struct nk_font_glyph*
+nk_font_cache_find(struct nk_font_cache *cache, const struct nk_font *font,
+    nk_rune unicode)
+{
+    int slot, config;
+    nk_uint key;
+    NK_ASSERT(unicode < 0x200000);
+    NK_ASSERT(font->config < 0x800);
+
+    key = ((nk_uint)font->config << 21) | (unicode & 0x1FFFFF);
+    slot = nk_font_cache_lookup(cache, key);
+    if (slot < 0) {
+        /* miss: rasterize the glyph from the first font covering it */
+        config = nk_font_cache_config(cache, font->config, unicode);
+        if (config < 0) {
+            if (unicode == font->fallback_codepoint)
+                return &cache->empty;
+            return nk_font_cache_find(cache, font, font->fallback_codepoint);
+        }
+        slot = nk_font_cache_add(cache, config, key, unicode, font->info.ascent);
+        if (slot < 0) return &cache->overflow;
+    }
+    cache->shelves[cache->entries[slot].shelf].frame = cache->frame;
+    return &cache->glyphs[slot];
+}
+
 /* -------------------------------------------------------------
  *
  *                          FONT
  *
  * --------------------------------------------------------------*/
+NK_INTERN const struct nk_font_glyph*
+nk_font_lookup(struct nk_font *font, nk_rune unicode, struct nk_font **owner)
+{
+    /* finds the glyph for `unicode` in the font or its fallback chain
+     * and returns the font owning the glyph in `owner` */
+    nk_rune total_glyphs = 0;
+    const nk_rune *range;
+    NK_ASSERT(font);
+    NK_ASSERT(font->glyphs);
+
+    *owner = font;
+    if (font->index.slots) {
+        /* constant time lookup: direct first page and two-level page table */
+        nk_uint slot = 0;
+        if (unicode < 256)
+            slot = font->index.slots[unicode];
+        else if (unicode < font->index.count)
+            slot = font->index.slots[((nk_uint)font->index.pages[unicode >> 8] << 8) | (unicode & 0xFF)];
+        if (!slot) {
+            if (font->cache)
+                return nk_font_cache_find(font->cache, font, unicode);
+            return font->fallback;
+        }
+        if (slot >> 24)
+            *owner = font = font->fallbacks[(slot >> 24) - 1];
+        if (font->cache)
+            return nk_font_cache_find(font->cache, font, unicode);
+        return &font->glyphs[(slot & 0xFFFFFF) - 1];
+    }
+    if (font->cache)
+        return nk_font_cache_find(font->cache, font, unicode);
+
+    /* no lookup table so walk all ranges */
+    for (range = font->info.ranges; range[0] && range[1]; range += 2) {
+        if (unicode >= range[0] && unicode <= range[1])
+            return &font->glyphs[total_glyphs + (unicode - range[0])];
+        total_glyphs += (range[1] - range[0]) + 1;
+    }
+    return font->fallback;
+}
+
+NK_INTERN float
+nk_font_chain_kerning(struct nk_font *font, struct nk_font *owner,
+    nk_rune left, nk_rune right)
+{
+    /* kerning only applies between two glyphs of the same font */
+    struct nk_font *right_owner = owner;
+    if (!owner->kerning.capacity || !right || right == NK_UTF_INVALID)
+        return 0;
+    if (font->fallback_count)
+        nk_font_lookup(font, right, &right_owner);
+    return (right_owner == owner) ? nk_font_find_kerning(owner, left, right): 0;
+}
+
 NK_INTERN float
 nk_font_text_width(nk_handle handle, float height, const char *text, int len)
 {
-    nk_rune unicode;
+    nk_rune unicode, prev;
     int text_len  = 0;
     float text_width = 0;
     int glyph_len = 0;
     float scale = 0;
+    const struct nk_font_glyph *g;
+    struct nk_font *owner, *next_owner;
 
     struct nk_font *font = (struct nk_font*)handle.ptr;
     NK_ASSERT(font);
@@ -9103,75 +12241,302 @@ nk_font_text_width(nk_handle handle, float height, const char *text, int len)
     if (!font || !text || !len)
         return 0;
 
-    scale = height/font->info.height;
     glyph_len = text_len = nk_utf_decode(text, &unicode, (int)len);
     if (!glyph_len) return 0;
+    g = nk_font_lookup(font, unicode, &owner);
     while (text_len <= (int)len && glyph_len) {
-        const struct nk_font_glyph *g;
         if (unicode == NK_UTF_INVALID) break;
 
         /* query currently drawn glyph information */
-        g = nk_font_find_glyph(font, unicode);
+        scale = height/owner->info.height;
         text_width += g->xadvance * scale;
 
         /* offset next glyph */
+        prev = unicode;
         glyph_len = nk_utf_decode(text + text_len, &unicode, (int)len - text_len);
         text_len += glyph_len;
+        if (!glyph_len || unicode == NK_UTF_INVALID) break;
+        g = nk_font_lookup(font, unicode, &next_owner);
+        if (next_owner == owner && owner->kerning.capacity)
+            text_width += nk_font_find_kerning(owner, prev, unicode) * scale;
+        owner = next_owner;
+    }
+    return text_width;
+}
+
+#ifdef NK_INCLUDE_GLYPH_ADVANCE
+NK_INTERN float
+nk_font_text_advance(nk_handle handle, float height, nk_rune unicode,
+    nk_rune next_codepoint)
+{
+    const struct nk_font_glyph *g;
+    struct nk_font *owner;
+    struct nk_font *font = (struct nk_font*)handle.ptr;
+    NK_ASSERT(font);
+    NK_ASSERT(font->glyphs);
+    if (!font || unicode == NK_UTF_INVALID)
+        return 0;
+
+    g = nk_font_lookup(font, unicode, &owner);
+    return (g->xadvance + nk_font_chain_kerning(font, owner, unicode, next_codepoint))
+        * (height/owner->info.height);
+}
+#endif
+
+#ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+NK_INTERN void
+nk_font_query_font_glyph(nk_handle handle, float height,
+    struct nk_user_font_glyph *glyph, nk_rune codepoint, nk_rune next_codepoint)
+{
+    float scale;
+    const struct nk_font_glyph *g;
+    struct nk_font *font, *owner;
+
+    NK_ASSERT(glyph);
+
+    font = (struct nk_font*)handle.ptr;
+    NK_ASSERT(font);
+    NK_ASSERT(font->glyphs);
+    if (!font || !glyph)
+        return;
+
+    g = nk_font_lookup(font, codepoint, &owner);
+    scale = height/owner->info.height;
+    glyph->width = (g->x1 - g->x0) * scale;
+    glyph->height = (g->y1 - g->y0) * scale;
+    glyph->offset = nk_vec2(g->x0 * scale, g->y0 * scale);
+    glyph->xadvance = (g->xadvance + nk_font_chain_kerning(font, owner, codepoint, next_codepoint)) * scale;
+    glyph->uv[0] = nk_vec2(g->u0, g->v0);
+    glyph->uv[1] = nk_vec2(g->u1, g->v1);
+    if (owner != font) {
+        /* move fallback glyphs onto the baseline of this font */
+        glyph->offset.y += font->info.ascent * (height/font->info.height) - owner->info.ascent * scale;
+        glyph->texture = owner->texture;
+    }
+    if (g->page && owner->pages)
+        glyph->texture = owner->pages[g->page].texture;
+}
+#endif
+
+NK_API const struct nk_font_glyph*
+nk_font_find_glyph(struct nk_font *font, nk_rune unicode)
+{
+    struct nk_font *owner;
+    return nk_font_lookup(font, unicode, &owner);
+}
+
+NK_INTERN nk_uint
+nk_font_kerning_hash(nk_rune left, nk_rune right)
+{
+    nk_uint key = ((nk_uint)left << 16) ^ (nk_uint)right;
+    key *= 2654435761u;
+    return key ^ (key >> 16);
+}
+
+NK_API float
+nk_font_find_kerning(const struct nk_font *font, nk_rune left, nk_rune right)
+{
+    nk_uint mask, i;
+    NK_ASSERT(font);
+    if (!font || !font->kerning.capacity || !left || !right)
+        return 0;
+
+    mask = font->kerning.capacity - 1;
+    i = nk_font_kerning_hash(left, right) & mask;
+    while (font->kerning.pairs[i].left) {
+        const struct nk_font_kerning_pair *pair = &font->kerning.pairs[i];
+        if (pair->left == left && pair->right == right)
+            return pair->advance;
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+NK_INTERN nk_rune
+nk_font_index_pages(const nk_rune *ranges, nk_rune *max_page)
+{
+    /* upper bound of used pages. Pages shared between ranges are counted
+     * multiple times which only wastes some memory */
+    const nk_rune *range;
+    nk_rune page_count = 0;
+    *max_page = 0;
+    for (range = ranges; range[0] && range[1]; range += 2) {
+        page_count += ((range[1] >> 8) - (range[0] >> 8)) + 1;
+        *max_page = NK_MAX(*max_page, range[1] >> 8);
+    }
+    return page_count;
+}
+
+NK_API void
+nk_font_index_memory(nk_size *memory, const struct nk_baked_font *baked_font)
+{
+    NK_STORAGE const nk_size slot_align = NK_ALIGNOF(nk_uint);
+    nk_rune max_page = 0;
+    nk_rune page_count = 0;
+    NK_ASSERT(memory);
+    NK_ASSERT(baked_font);
+    if (!memory) return;
+    *memory = 0;
+    if (!baked_font || !baked_font->ranges) return;
+
+    /* direct page + empty page + upper bound of used pages */
+    page_count = 2 + nk_font_index_pages(baked_font->ranges, &max_page);
+    *memory = (nk_size)page_count * 256 * sizeof(nk_uint);
+    *memory += (nk_size)(max_page + 1) * sizeof(nk_ushort);
+    *memory += slot_align;
+}
+
+NK_INTERN void
+nk_font_index_ranges(nk_uint *slots, nk_ushort *pages, nk_uint *page_count,
+    const nk_rune *ranges, nk_uint owner)
+{
+    /* map each codepoint without a glyph yet to its glyph. Overlapping
+     * ranges resolve to the first range just like the range walk */
+    nk_rune total_glyphs = 0;
+    const nk_rune *range;
+    for (range = ranges; range[0] && range[1]; range += 2) {
+        nk_rune unicode;
+        for (unicode = range[0]; unicode <= range[1]; ++unicode) {
+            nk_uint *slot;
+            if (pages[unicode >> 8] == 1) {
+                pages[unicode >> 8] = (nk_ushort)*page_count;
+                nk_zero(&slots[*page_count << 8], 256 * sizeof(nk_uint));
+                (*page_count)++;
+            }
+            slot = &slots[((nk_uint)pages[unicode >> 8] << 8) | (unicode & 0xFF)];
+            if (!*slot) *slot = (owner << 24) | ((nk_uint)(total_glyphs + (unicode - range[0])) + 1);
+        }
+        total_glyphs += (range[1] - range[0]) + 1;
+    }
+}
+
+NK_INTERN nk_ushort*
+nk_font_index_setup(nk_uint *slots, nk_rune page_count, nk_rune max_page)
+{
+    /* setup page table behind the slots. All pages start out as
+     * the empty page (1) which maps every codepoint to the fallback glyph */
+    nk_ushort *pages = (nk_ushort*)(void*)(slots + page_count * 256);
+    nk_rune i;
+    nk_zero(slots, 2 * 256 * sizeof(nk_uint));
+    for (i = 0; i <= max_page; ++i)
+        pages[i] = 1;
+    pages[0] = 0;
+    return pages;
+}
+
+NK_API void
+nk_font_index(struct nk_font *font, void *memory, nk_size size)
+{
+    NK_STORAGE const nk_size slot_align = NK_ALIGNOF(nk_uint);
+    nk_size needed;
+    nk_rune max_page;
+    nk_uint page_count = 2;
+    nk_rune slot_pages;
+    nk_ushort *pages;
+    nk_uint *slots;
+
+    NK_ASSERT(font);
+    NK_ASSERT(memory);
+    if (!font || !memory || !font->info.ranges) return;
+    nk_font_index_memory(&needed, &font->info);
+    NK_ASSERT(size >= needed);
+    if (size < needed) return;
+
+    slots = (nk_uint*)NK_ALIGN_PTR(memory, slot_align);
+    slot_pages = 2 + nk_font_index_pages(font->info.ranges, &max_page);
+    pages = nk_font_index_setup(slots, slot_pages, max_page);
+    nk_font_index_ranges(slots, pages, &page_count, font->info.ranges, 0);
+    font->index.slots = slots;
+    font->index.pages = pages;
+    font->index.count = (max_page + 1) << 8;
+    font->fallbacks = 0;
+    font->fallback_count = 0;
+}
+
+NK_INTERN nk_rune
+nk_font_fallback_pages(const struct nk_font *font,
+    struct nk_font *const *fallbacks, int count, nk_rune *max_page)
+{
+    /* direct page + empty page + upper bound of used pages of all fonts */
+    nk_rune page_count = 2;
+    int i;
+    *max_page = 0;
+    for (i = -1; i < count; ++i) {
+        const struct nk_font *f = (i < 0) ? font: fallbacks[i];
+        nk_rune font_max_page = 0;
+        if (!f || !f->info.ranges) continue;
+        page_count += nk_font_index_pages(f->info.ranges, &font_max_page);
+        *max_page = NK_MAX(*max_page, font_max_page);
     }
-    return text_width;
+    return page_count;
 }
 
-#ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
-NK_INTERN void
-nk_font_query_font_glyph(nk_handle handle, float height,
-    struct nk_user_font_glyph *glyph, nk_rune codepoint, nk_rune next_codepoint)
+NK_API void
+nk_font_fallback_memory(nk_size *memory, const struct nk_font *font,
+    struct nk_font *const *fallbacks, int count)
 {
-    float scale;
-    const struct nk_font_glyph *g;
-    struct nk_font *font;
-
-    NK_ASSERT(glyph);
-    NK_UNUSED(next_codepoint);
-
-    font = (struct nk_font*)handle.ptr;
+    NK_STORAGE const nk_size font_align = NK_ALIGNOF(struct nk_font*);
+    NK_STORAGE const nk_size slot_align = NK_ALIGNOF(nk_uint);
+    nk_rune max_page = 0;
+    nk_rune page_count = 0;
+    NK_ASSERT(memory);
     NK_ASSERT(font);
-    NK_ASSERT(font->glyphs);
-    if (!font || !glyph)
+    NK_ASSERT(fallbacks || !count);
+    NK_ASSERT(count >= 0 && count < 255);
+    if (!memory) return;
+    *memory = 0;
+    if (!font || !font->info.ranges || (!fallbacks && count) || count < 0 || count >= 255)
         return;
 
-    scale = height/font->info.height;
-    g = nk_font_find_glyph(font, codepoint);
-    glyph->width = (g->x1 - g->x0) * scale;
-    glyph->height = (g->y1 - g->y0) * scale;
-    glyph->offset = nk_vec2(g->x0 * scale, g->y0 * scale);
-    glyph->xadvance = (g->xadvance * scale);
-    glyph->uv[0] = nk_vec2(g->u0, g->v0);
-    glyph->uv[1] = nk_vec2(g->u1, g->v1);
+    page_count = nk_font_fallback_pages(font, fallbacks, count, &max_page);
+    *memory = (nk_size)count * sizeof(struct nk_font*);
+    *memory += (nk_size)page_count * 256 * sizeof(nk_uint);
+    *memory += (nk_size)(max_page + 1) * sizeof(nk_ushort);
+    *memory += font_align + slot_align;
 }
-#endif
 
-NK_API const struct nk_font_glyph*
-nk_font_find_glyph(struct nk_font *font, nk_rune unicode)
+NK_API void
+nk_font_fallback(struct nk_font *font, struct nk_font *const *fallbacks,
+    int count, void *memory, nk_size size)
 {
-    int i = 0;
-    int count;
-    int total_glyphs = 0;
-    const struct nk_font_glyph *glyph = 0;
-    NK_ASSERT(font);
-    NK_ASSERT(font->glyphs);
+    NK_STORAGE const nk_size font_align = NK_ALIGNOF(struct nk_font*);
+    NK_STORAGE const nk_size slot_align = NK_ALIGNOF(nk_uint);
+    nk_size needed;
+    nk_rune max_page;
+    nk_uint page_count = 2;
+    nk_rune slot_pages;
+    struct nk_font **chain;
+    nk_ushort *pages;
+    nk_uint *slots;
+    int i;
 
-    glyph = font->fallback;
-    count = nk_range_count(font->info.ranges);
+    NK_ASSERT(font);
+    NK_ASSERT(memory);
+    if (!font || !memory) return;
+    nk_font_fallback_memory(&needed, font, fallbacks, count);
+    NK_ASSERT(needed && size >= needed);
+    if (!needed || size < needed) return;
+
+    /* fallback chain in front of the merged page table. The font itself
+     * takes precedence, followed by its fallbacks in list order */
+    chain = (struct nk_font**)NK_ALIGN_PTR(memory, font_align);
     for (i = 0; i < count; ++i) {
-        int diff;
-        nk_rune f = font->info.ranges[(i*2)+0];
-        nk_rune t = font->info.ranges[(i*2)+1];
-        diff = (int)((t - f) + 1);
-        if (unicode >= f && unicode <= t)
-            return &font->glyphs[((nk_rune)total_glyphs + (unicode - f))];
-        total_glyphs += diff;
+        NK_ASSERT(fallbacks[i] != font);
+        chain[i] = fallbacks[i];
+    }
+    slots = (nk_uint*)NK_ALIGN_PTR((chain + count), slot_align);
+    slot_pages = nk_font_fallback_pages(font, fallbacks, count, &max_page);
+    pages = nk_font_index_setup(slots, slot_pages, max_page);
+    nk_font_index_ranges(slots, pages, &page_count, font->info.ranges, 0);
+    for (i = 0; i < count; ++i) {
+        if (!chain[i] || chain[i] == font || !chain[i]->info.ranges) continue;
+        nk_font_index_ranges(slots, pages, &page_count, chain[i]->info.ranges, (nk_uint)i + 1);
     }
-    return glyph;
+    font->index.slots = slots;
+    font->index.pages = pages;
+    font->index.count = (max_page + 1) << 8;
+    font->fallbacks = chain;
+    font->fallback_count = count;
 }
 
 NK_API void
@@ -9197,6 +12562,9 @@ nk_font_init(struct nk_font *font, float pixel_height,
 
     font->handle.height = font->info.height * font->scale;
     font->handle.width = nk_font_text_width;
+#ifdef NK_INCLUDE_GLYPH_ADVANCE
+    font->handle.advance = nk_font_text_advance;
+#endif
     font->handle.userdata.ptr = font;
 #ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
     font->handle.query = nk_font_query_font_glyph;
@@ -9545,11 +12913,31 @@ nk_font_atlas_begin(struct nk_font_atlas *atlas)
         atlas->permanent.free(atlas->permanent.userdata, atlas->glyphs);
         atlas->glyphs = 0;
     }
+    if (atlas->glyph_index) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->glyph_index);
+        atlas->glyph_index = 0;
+    }
+    if (atlas->kerning) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->kerning);
+        atlas->kerning = 0;
+    }
+    if (atlas->pages) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->pages);
+        atlas->pages = 0;
+        atlas->page_count = 0;
+    }
+    if (atlas->fallback) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->fallback);
+        atlas->fallback = 0;
+    }
     if (atlas->pixel) {
         atlas->permanent.free(atlas->permanent.userdata, atlas->pixel);
         atlas->pixel = 0;
     }
-
+    if (atlas->cache) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->cache->memory);
+        atlas->cache = 0;
+    }
 }
 
 NK_API struct nk_font*
@@ -9761,23 +13149,188 @@ nk_font_atlas_add_default(struct nk_font_atlas *atlas,
 }
 #endif
 
-NK_API const void*
-nk_font_atlas_bake(struct nk_font_atlas *atlas, int *width, int *height,
-    enum nk_font_atlas_format fmt)
+NK_INTERN int
+nk_font_kerning_add(struct nk_font_kerning_pair *table, nk_uint capacity,
+    const struct nk_font_config *cfg, struct nk_allocator *alloc)
+{
+    /* maps each glyph of the configured ranges back to its codepoints and
+     * returns the number of `kern` pairs between them. Pairs are only
+     * inserted into `table` if it is not 0 */
+    struct nk_tt_fontinfo info;
+    const nk_byte *pairs = 0;
+    const nk_rune *range;
+    int pair_count, i, n = 0;
+    nk_rune cp, total = 0, mapped = 0;
+    nk_uint *first = 0;
+    nk_rune *codepoints;
+    nk_ushort *glyphs;
+    float scale;
+    void *memory;
+
+    if (!cfg->ttf_blob || !cfg->range) return 0;
+    if (!nk_tt_InitFont(&info, (const unsigned char*)cfg->ttf_blob, 0)) return 0;
+    pair_count = nk_tt_GetKerningPairs(&info, &pairs);
+    if (!pair_count) return 0;
+    for (range = cfg->range; range[0] && range[1]; range += 2)
+        total += (range[1] - range[0]) + 1;
+
+    /* glyph of each codepoint, codepoints sorted by glyph and first
+     * codepoint index of each glyph plus one trailing end index */
+    memory = alloc->alloc(alloc->userdata, 0, (nk_size)total * sizeof(nk_rune)
+        + (nk_size)total * sizeof(nk_ushort) + (nk_size)(info.numGlyphs + 1) * sizeof(nk_uint));
+    if (!memory) return 0;
+    codepoints = (nk_rune*)memory;
+    first = (nk_uint*)(codepoints + total);
+    glyphs = (nk_ushort*)(first + info.numGlyphs + 1);
+    nk_zero(first, (nk_size)(info.numGlyphs + 1) * sizeof(nk_uint));
+
+    total = 0;
+    for (range = cfg->range; range[0] && range[1]; range += 2) {
+        for (cp = range[0]; cp <= range[1]; ++cp, ++total) {
+            int glyph = nk_tt_FindGlyphIndex(&info, (int)cp);
+            glyphs[total] = (nk_ushort)glyph;
+            if (glyph > 0 && glyph < info.numGlyphs) first[glyph]++;
+        }
+    }
+    for (i = 0; i <= info.numGlyphs; ++i) {
+        nk_uint count = first[i];
+        first[i] = mapped;
+        mapped += count;
+    }
+    total = 0;
+    for (range = cfg->range; range[0] && range[1]; range += 2) {
+        for (cp = range[0]; cp <= range[1]; ++cp, ++total) {
+            int glyph = glyphs[total];
+            if (glyph > 0 && glyph < info.numGlyphs)
+                codepoints[first[glyph]++] = cp;
+        }
+    }
+    /* filling moved each start index to the start of the next glyph */
+    for (i = info.numGlyphs; i > 0; --i)
+        first[i] = first[i-1];
+    first[0] = 0;
+
+    scale = nk_tt_ScaleForPixelHeight(&info, cfg->size);
+    for (i = 0; i < pair_count; ++i) {
+        const nk_byte *pair = pairs + i * 6;
+        int left = nk_ttUSHORT(pair);
+        int right = nk_ttUSHORT(pair + 2);
+        float advance = (float)nk_ttSHORT(pair + 4) * scale;
+        nk_uint l, r;
+        if (left >= info.numGlyphs || right >= info.numGlyphs) continue;
+        if (cfg->pixel_snap)
+            advance = (float)(int)(advance + ((advance < 0) ? -0.5f: 0.5f));
+        if (advance == 0) continue;
+
+        for (l = first[left]; l < first[left+1]; ++l) {
+            for (r = first[right]; r < first[right+1]; ++r, ++n) {
+                nk_uint mask, slot;
+                if (!table) continue;
+                mask = capacity - 1;
+                slot = nk_font_kerning_hash(codepoints[l], codepoints[r]) & mask;
+                while (table[slot].left && (table[slot].left != codepoints[l] ||
+                    table[slot].right != codepoints[r]))
+                    slot = (slot + 1) & mask;
+                if (table[slot].left) continue;
+                table[slot].left = codepoints[l];
+                table[slot].right = codepoints[r];
+                table[slot].advance = advance;
+            }
+        }
+    }
+    alloc->free(alloc->userdata, memory);
+    return n;
+}
+
+NK_INTERN void
+nk_font_atlas_init_kerning(struct nk_font_atlas *atlas)
+{
+    /* build the kerning table of each font including merged fonts. Fonts
+     * without `kern` table or without memory are drawn without kerning */
+    int i, c;
+    nk_size size = 0;
+    struct nk_font_kerning_pair *pairs;
+    for (i = 0; i < atlas->font_num; ++i) {
+        nk_uint count = 0;
+        if (atlas->config[i].merge_mode) continue;
+        for (c = i; c < atlas->font_num && (c == i || atlas->config[c].merge_mode); ++c)
+            count += (nk_uint)nk_font_kerning_add(0, 0, &atlas->config[c], &atlas->temporary);
+        atlas->fonts[i]->kerning.pairs = 0;
+        atlas->fonts[i]->kerning.capacity = (count) ? nk_round_up_pow2(count * 2): 0;
+        size += atlas->fonts[i]->kerning.capacity * sizeof(struct nk_font_kerning_pair);
+    }
+    if (size)
+        atlas->kerning = atlas->permanent.alloc(atlas->permanent.userdata,0, size);
+    if (!atlas->kerning) {
+        for (i = 0; i < atlas->font_num; ++i)
+            if (!atlas->config[i].merge_mode)
+                atlas->fonts[i]->kerning.capacity = 0;
+        return;
+    }
+
+    nk_zero(atlas->kerning, size);
+    pairs = (struct nk_font_kerning_pair*)atlas->kerning;
+    for (i = 0; i < atlas->font_num; ++i) {
+        struct nk_font *font = atlas->fonts[i];
+        if (atlas->config[i].merge_mode || !font->kerning.capacity) continue;
+        for (c = i; c < atlas->font_num && (c == i || atlas->config[c].merge_mode); ++c)
+            nk_font_kerning_add(pairs, font->kerning.capacity, &atlas->config[c], &atlas->temporary);
+        font->kerning.pairs = pairs;
+        pairs += font->kerning.capacity;
+    }
+}
+
+NK_INTERN void
+nk_font_atlas_init_fonts(struct nk_font_atlas *atlas)
+{
+    int i = 0;
+    /* initialize each font */
+    for (i = 0; i < atlas->font_num; ++i) {
+        nk_font_init(atlas->fonts[i], atlas->config[i].size,
+            atlas->config[i].fallback_glyph, atlas->glyphs,
+            atlas->config[i].font, nk_handle_ptr(0));
+        atlas->fonts[i]->pages = atlas->pages;
+    }
+
+    /* build glyph lookup table for each font. Fonts without a table
+     * still work by walking their ranges so failing is not fatal */
+    {nk_size index_size = 0;
+    for (i = 0; i < atlas->font_num; ++i) {
+        nk_size font_index_size;
+        if (atlas->config[i].merge_mode) continue;
+        nk_font_index_memory(&font_index_size, &atlas->fonts[i]->info);
+        index_size += font_index_size;
+    }
+    atlas->glyph_index = atlas->permanent.alloc(atlas->permanent.userdata,0, index_size);
+    if (atlas->glyph_index) {
+        nk_byte *index_memory = (nk_byte*)atlas->glyph_index;
+        for (i = 0; i < atlas->font_num; ++i) {
+            nk_size font_index_size;
+            if (atlas->config[i].merge_mode) continue;
+            nk_font_index_memory(&font_index_size, &atlas->fonts[i]->info);
+            nk_font_index(atlas->fonts[i], index_memory, font_index_size);
+            index_memory += font_index_size;
+        }
+    }}
+    nk_font_atlas_init_kerning(atlas);
+}
+
+NK_INTERN int
+nk_font_atlas_bake_internal(struct nk_font_atlas *atlas, int page_width,
+    int page_height, int max_pages, enum nk_font_atlas_format fmt,
+    const struct nk_font_bake_dispatcher *dispatcher)
 {
     int i = 0;
     void *tmp = 0;
-    nk_size tmp_size, img_size;
+    nk_size tmp_size, img_size = 0;
+    struct nk_font_baker *baker;
 
-    NK_ASSERT(width);
-    NK_ASSERT(height);
     NK_ASSERT(atlas);
     NK_ASSERT(atlas->temporary.alloc);
     NK_ASSERT(atlas->temporary.free);
     NK_ASSERT(atlas->permanent.alloc);
     NK_ASSERT(atlas->permanent.free);
-    if (!atlas || !width || !height ||
-        !atlas->temporary.alloc || !atlas->temporary.free ||
+    if (!atlas || !atlas->temporary.alloc || !atlas->temporary.free ||
         !atlas->permanent.alloc || !atlas->permanent.free)
         return 0;
 
@@ -9802,75 +13355,623 @@ nk_font_atlas_bake(struct nk_font_atlas *atlas, int *width, int *height,
     NK_ASSERT(atlas->glyphs);
     if (!atlas->glyphs)
         goto failed;
+    nk_zero(atlas->glyphs, sizeof(struct nk_font_glyph) * (nk_size)atlas->glyph_count);
 
     /* pack all glyphs into a tight fit space */
     atlas->custom.w = 2; atlas->custom.h = 2;
-    if (!nk_font_bake_pack(&img_size, width, height, &atlas->custom, tmp, tmp_size,
-        atlas->config, atlas->font_num, &atlas->temporary))
+    if (!nk_font_bake_pack_pages(&atlas->custom, tmp, tmp_size, atlas->config,
+        atlas->font_num, page_width, page_height, max_pages, &atlas->temporary))
         goto failed;
+    baker = (struct nk_font_baker*)NK_ALIGN_PTR(tmp, nk_baker_align);
 
-    /* allocate memory for the baked image font atlas */
+    /* allocate page descriptions and a single image block for all pages */
+    atlas->pages = (struct nk_font_atlas_page*)
+        atlas->permanent.alloc(atlas->permanent.userdata,0,
+                sizeof(struct nk_font_atlas_page) * (nk_size)baker->page_count);
+    NK_ASSERT(atlas->pages);
+    if (!atlas->pages)
+        goto failed;
+    for (i = 0; i < baker->page_count; ++i)
+        img_size += (nk_size)baker->pages[i].width * (nk_size)baker->pages[i].height;
     atlas->pixel = atlas->temporary.alloc(atlas->temporary.userdata,0, img_size);
     NK_ASSERT(atlas->pixel);
     if (!atlas->pixel)
         goto failed;
+    nk_zero(atlas->pixel, img_size);
+    {nk_byte *pixel = (nk_byte*)atlas->pixel;
+    for (i = 0; i < baker->page_count; ++i) {
+        baker->pages[i].pixel = pixel;
+        pixel += (nk_size)baker->pages[i].width * (nk_size)baker->pages[i].height;
+    }}
 
     /* bake glyphs and custom white pixel into image */
     {const char *custom_data = "....";
-    nk_font_bake(atlas->pixel, *width, *height, tmp, tmp_size, atlas->glyphs,
-        atlas->glyph_count, atlas->config, atlas->font_num);
-    nk_font_bake_custom_data(atlas->pixel, *width, *height, atlas->custom,
-            custom_data, 2, 2, '.', 'X');}
+    nk_font_bake_render(baker, atlas->glyphs, atlas->config, atlas->font_num, dispatcher);
+    nk_font_bake_custom_data(atlas->pixel, baker->pages[0].width, baker->pages[0].height,
+        atlas->custom, custom_data, 2, 2, '.', 'X');}
 
     /* convert alpha8 image into rgba32 image */
     if (fmt == NK_FONT_ATLAS_RGBA32) {
-        void *img_rgba = atlas->temporary.alloc(atlas->temporary.userdata,0,
-                            (nk_size)(*width * *height * 4));
+        void *img_rgba = atlas->temporary.alloc(atlas->temporary.userdata,0, img_size * 4);
         NK_ASSERT(img_rgba);
         if (!img_rgba) goto failed;
-        nk_font_bake_convert(img_rgba, *width, *height, atlas->pixel);
+        nk_font_bake_convert(img_rgba, (int)img_size, 1, atlas->pixel);
         atlas->temporary.free(atlas->temporary.userdata, atlas->pixel);
         atlas->pixel = img_rgba;
     }
-    atlas->tex_width = *width;
-    atlas->tex_height = *height;
+    {nk_byte *pixel = (nk_byte*)atlas->pixel;
+    nk_size bpp = (fmt == NK_FONT_ATLAS_RGBA32) ? 4: 1;
+    for (i = 0; i < baker->page_count; ++i) {
+        atlas->pages[i] = baker->pages[i];
+        atlas->pages[i].pixel = pixel;
+        atlas->pages[i].texture = nk_handle_ptr(0);
+        pixel += (nk_size)baker->pages[i].width * (nk_size)baker->pages[i].height * bpp;
+    }}
+    atlas->page_count = baker->page_count;
+    atlas->tex_width = atlas->pages[0].width;
+    atlas->tex_height = atlas->pages[0].height;
+    atlas->format = fmt;
+    nk_font_atlas_init_fonts(atlas);
+
+    /* free temporary memory */
+    atlas->temporary.free(atlas->temporary.userdata, tmp);
+    return 1;
+
+failed:
+    /* error so cleanup all memory */
+    if (tmp) atlas->temporary.free(atlas->temporary.userdata, tmp);
+    if (atlas->glyphs) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->glyphs);
+        atlas->glyphs = 0;
+    }
+    if (atlas->pages) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->pages);
+        atlas->pages = 0;
+    }
+    if (atlas->pixel) {
+        atlas->temporary.free(atlas->temporary.userdata, atlas->pixel);
+        atlas->pixel = 0;
+    }
+    return 0;
+}
+
+NK_API const void*
+nk_font_atlas_bake(struct nk_font_atlas *atlas, int *width, int *height,
+    enum nk_font_atlas_format fmt)
+{
+    return nk_font_atlas_bake_parallel(atlas, width, height, fmt, 0);
+}
+
+NK_API const void*
+nk_font_atlas_bake_parallel(struct nk_font_atlas *atlas, int *width, int *height,
+    enum nk_font_atlas_format fmt, const struct nk_font_bake_dispatcher *dispatcher)
+{
+    NK_ASSERT(width);
+    NK_ASSERT(height);
+    if (!width || !height) return 0;
+    if (!nk_font_atlas_bake_internal(atlas, nk_bake_max_width, nk_bake_max_height,
+        1, fmt, dispatcher)) return 0;
+    *width = atlas->tex_width;
+    *height = atlas->tex_height;
+    return atlas->pixel;
+}
+
+NK_API const struct nk_font_atlas_page*
+nk_font_atlas_bake_pages(struct nk_font_atlas *atlas, int page_width,
+    int page_height, enum nk_font_atlas_format fmt,
+    const struct nk_font_bake_dispatcher *dispatcher, int *page_count)
+{
+    NK_ASSERT(page_count);
+    NK_ASSERT(page_width > 0);
+    NK_ASSERT(page_height > 0);
+    if (!page_count || page_width <= 0 || page_height <= 0) return 0;
+    *page_count = 0;
+    if (!nk_font_atlas_bake_internal(atlas, NK_MIN(page_width, nk_bake_max_width),
+        NK_MIN(page_height, nk_bake_max_height), 0, fmt, dispatcher)) return 0;
+    *page_count = atlas->page_count;
+    return atlas->pages;
+}
+
+NK_API const void*
+nk_font_atlas_bake_dynamic(struct nk_font_atlas *atlas, int width, int height,
+    enum nk_font_atlas_format fmt)
+{
+    int i = 0;
+    int glyph_capacity, shelf_capacity;
+    nk_uint table_capacity;
+    float min_size;
+    nk_size size;
+    void *memory = 0;
+    struct nk_font_cache *cache;
+
+    NK_ASSERT(atlas);
+    NK_ASSERT(width > 0 && height > 0);
+    NK_ASSERT(atlas->temporary.alloc);
+    NK_ASSERT(atlas->temporary.free);
+    NK_ASSERT(atlas->permanent.alloc);
+    NK_ASSERT(atlas->permanent.free);
+    if (!atlas || width <= 0 || height <= 0 ||
+        !atlas->temporary.alloc || !atlas->temporary.free ||
+        !atlas->permanent.alloc || !atlas->permanent.free)
+        return 0;
+
+#ifdef NK_INCLUDE_DEFAULT_FONT
+    /* no font added so just use default font */
+    if (!atlas->font_num)
+        atlas->default_font = nk_font_atlas_add_default(atlas, 13.0f, 0);
+#endif
+    NK_ASSERT(atlas->font_num);
+    NK_ASSERT(atlas->font_num <= 0x800);
+    if (!atlas->font_num || atlas->font_num > 0x800) return 0;
+
+    /* size glyph slots for the smallest font filling the whole page */
+    min_size = atlas->config[0].size;
+    for (i = 1; i < atlas->font_num; ++i)
+        min_size = NK_MIN(min_size, atlas->config[i].size);
+    glyph_capacity = (int)(((float)width * (float)height * 2.0f) / (min_size * min_size));
+    glyph_capacity = NK_CLAMP(64, glyph_capacity, 0xFFFF);
+    table_capacity = nk_round_up_pow2((nk_uint)glyph_capacity * 2);
+    shelf_capacity = height / 4 + 1;
+
+    /* allocate cache and page memory */
+    size = nk_font_cache_memory(atlas->font_num, glyph_capacity, table_capacity, shelf_capacity);
+    memory = atlas->permanent.alloc(atlas->permanent.userdata, 0, size);
+    NK_ASSERT(memory);
+    if (!memory) goto failed;
+    cache = nk_font_cache(memory, atlas->font_num, glyph_capacity, table_capacity, shelf_capacity);
+    cache->memory = memory;
+    cache->config = atlas->config;
+    cache->alloc = atlas->temporary;
+    cache->width = width;
+    cache->height = height;
+    cache->format = fmt;
+    for (i = 0; i < atlas->font_num; ++i) {
+        const struct nk_font_config *cfg = &atlas->config[i];
+        if (!cfg->range) atlas->config[i].range = nk_font_default_glyph_ranges();
+        if (!nk_tt_InitFont(&cache->info[i], (const unsigned char*)cfg->ttf_blob, 0))
+            goto failed;
+    }
+    size = (nk_size)width * (nk_size)height;
+    if (fmt == NK_FONT_ATLAS_RGBA32) size *= 4;
+    atlas->pixel = atlas->permanent.alloc(atlas->permanent.userdata, 0, size);
+    NK_ASSERT(atlas->pixel);
+    if (!atlas->pixel) goto failed;
+    cache->pixel = atlas->pixel;
+    nk_font_cache_blit(cache, 0, 0, 0, width, height);
+
+    /* custom white pixel in the upper left corner above all shelves */
+    {const char *custom_data = "....";
+    nk_byte custom[5*3];
+    atlas->custom = nk_font_cache_rect(0, 0, 5, 3);
+    nk_zero(custom, sizeof(custom));
+    nk_font_bake_custom_data(custom, 5, 3, nk_font_cache_rect(0,0,0,0), custom_data, 2, 2, '.', 'X');
+    nk_font_cache_blit(cache, custom, 0, 0, 5, 3);
+    cache->top = 4;}
+    atlas->tex_width = width;
+    atlas->tex_height = height;
+
+    /* initialize each font with its vertical metrics only */
+    for (i = 0; i < atlas->font_num; ++i) {
+        struct nk_font_config *cfg = &atlas->config[i];
+        struct nk_baked_font *baked = cfg->font;
+        int ascent, descent, line_gap;
+        float scale;
+        if (cfg->merge_mode) continue;
+        scale = nk_tt_ScaleForPixelHeight(&cache->info[i], cfg->size);
+        nk_tt_GetFontVMetrics(&cache->info[i], &ascent, &descent, &line_gap);
+        baked->ranges = cfg->range;
+        baked->height = cfg->size;
+        baked->ascent = (float)ascent * scale;
+        baked->descent = (float)descent * scale;
+        baked->sdf_spread = (float)cfg->sdf_spread;
+        baked->glyph_offset = 0;
+        baked->glyph_count = 0;
+        nk_font_init(atlas->fonts[i], cfg->size, cfg->fallback_glyph,
+            cache->glyphs, baked, nk_handle_ptr(0));
+        atlas->fonts[i]->config = i;
+        atlas->fonts[i]->cache = cache;
+        atlas->fonts[i]->fallback = &cache->empty;
+    }
+    nk_font_atlas_init_kerning(atlas);
+    cache->is_dirty = nk_false;
+    atlas->cache = cache;
+    return atlas->pixel;
+
+failed:
+    if (memory) atlas->permanent.free(atlas->permanent.userdata, memory);
+    if (atlas->pixel) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->pixel);
+        atlas->pixel = 0;
+    }
+    return 0;
+}
+
+NK_API int
+nk_font_atlas_update(struct nk_font_atlas *atlas, struct nk_recti *dirty)
+{
+    int changed;
+    struct nk_font_cache *cache;
+    NK_ASSERT(atlas);
+    NK_ASSERT(dirty);
+    if (!atlas || !dirty || !atlas->cache)
+        return nk_false;
+
+    /* hand out the changed area and start a new frame which
+     * allows evicting glyphs used in the previous frame */
+    cache = atlas->cache;
+    changed = cache->is_dirty;
+    *dirty = (changed) ? cache->dirty: nk_font_cache_rect(0,0,0,0);
+    cache->is_dirty = nk_false;
+    cache->frame++;
+    return changed;
+}
+
+NK_INTERN float
+nk_font_glyph_texels(const struct nk_font_glyph *glyph,
+    enum nk_font_coord_type coord_type, int width, int height)
+{
+    float area = (glyph->u1 - glyph->u0) * (glyph->v1 - glyph->v0);
+    if (coord_type == NK_COORD_UV)
+        area *= (float)width * (float)height;
+    return area;
+}
+
+NK_API float
+nk_font_atlas_efficiency(const struct nk_font_atlas *atlas)
+{
+    /* ratio of texels used by glyphs and the custom region to all texels of
+     * the atlas image. Glyph padding and empty space count as waste */
+    int i;
+    nk_rune n;
+    float area, total;
+    NK_ASSERT(atlas);
+    if (!atlas || !atlas->tex_width || !atlas->tex_height)
+        return 0;
+
+    total = (float)atlas->tex_width * (float)atlas->tex_height;
+    if (atlas->pages && !atlas->cache) {
+        total = 0;
+        for (i = 0; i < atlas->page_count; ++i)
+            total += (float)atlas->pages[i].width * (float)atlas->pages[i].height;
+    }
+    area = (float)atlas->custom.w * (float)atlas->custom.h;
+    if (atlas->cache) {
+        const struct nk_font_cache *cache = atlas->cache;
+        nk_uint bucket;
+        for (bucket = 0; bucket < cache->table_capacity; ++bucket) {
+            int slot = cache->table[bucket] - 1;
+            if (slot < 0) continue;
+            area += nk_font_glyph_texels(&cache->glyphs[slot],
+                cache->config[cache->entries[slot].key >> 21].coord_type,
+                cache->width, cache->height);
+        }
+    } else if (atlas->glyphs) {
+        for (i = 0; i < atlas->font_num; ++i) {
+            const struct nk_font *font = atlas->fonts[i];
+            if (atlas->config[i].merge_mode) continue;
+            for (n = 0; n < font->info.glyph_count; ++n) {
+                const struct nk_font_glyph *g = &font->glyphs[n];
+                int width = atlas->tex_width, height = atlas->tex_height;
+                if (atlas->pages) {
+                    width = atlas->pages[g->page].width;
+                    height = atlas->pages[g->page].height;
+                }
+                area += nk_font_glyph_texels(g, atlas->config[i].coord_type, width, height);
+            }
+        }
+    }
+    return area / total;
+}
+
+/* Atlas blob layout: header followed by the baked font metrics of each
+ * non merged font, all glyphs and the atlas image. Every section starts at
+ * a 16 byte aligned offset and is stored in native byte order and layout */
+#define NK_FONT_ATLAS_BLOB_MAGIC 0x41464B4E
+#define NK_FONT_ATLAS_BLOB_VERSION 1
+#define NK_FONT_ATLAS_BLOB_ALIGN 16
+
+struct nk_font_atlas_blob {
+    nk_uint magic, version, byte_order;
+    nk_uint glyph_size; /* sizeof(struct nk_font_glyph) */
+    nk_uint key; /* hash of all font data and configuration */
+    nk_uint format, width, height;
+    nk_uint font_count, glyph_count;
+    short custom[4];
+    nk_uint font_offset, glyph_offset, pixel_offset;
+    nk_uint size;
+};
+
+struct nk_font_atlas_blob_font {
+    float height, ascent, descent;
+    nk_uint glyph_offset, glyph_count;
+};
+
+NK_INTERN nk_uint
+nk_font_atlas_key(const struct nk_font_atlas *atlas, enum nk_font_atlas_format fmt)
+{
+    /* hash of everything the baked atlas depends on */
+    int i;
+    nk_hash key = (nk_hash)fmt;
+    for (i = 0; i < atlas->font_num; ++i) {
+        const struct nk_font_config *cfg = &atlas->config[i];
+        const nk_rune *range = (cfg->range) ? cfg->range: nk_font_default_glyph_ranges();
+        float params[3];
+        nk_byte flags[6];
+        params[0] = cfg->size;
+        params[1] = cfg->spacing.x;
+        params[2] = cfg->spacing.y;
+        flags[0] = cfg->merge_mode;
+        flags[1] = cfg->pixel_snap;
+        flags[2] = cfg->oversample_h;
+        flags[3] = cfg->oversample_v;
+        flags[4] = (nk_byte)cfg->coord_type;
+        flags[5] = cfg->sdf_spread;
+        key = nk_murmur_hash(cfg->ttf_blob, (int)cfg->ttf_size, key);
+        key = nk_murmur_hash(params, (int)sizeof(params), key);
+        key = nk_murmur_hash(flags, (int)sizeof(flags), key);
+        key = nk_murmur_hash(&cfg->fallback_glyph, (int)sizeof(nk_rune), key);
+        key = nk_murmur_hash(range, (nk_range_count(range) * 2 + 1) * (int)sizeof(nk_rune), key);
+    }
+    return key;
+}
+
+NK_INTERN nk_uint
+nk_font_atlas_blob_layout(const struct nk_font_atlas *atlas,
+    enum nk_font_atlas_format fmt, int width, int height,
+    struct nk_font_atlas_blob *blob)
+{
+    int i;
+    nk_size offset;
+    nk_zero_struct(*blob);
+    blob->magic = NK_FONT_ATLAS_BLOB_MAGIC;
+    blob->version = NK_FONT_ATLAS_BLOB_VERSION;
+    blob->byte_order = 0x01020304;
+    blob->glyph_size = (nk_uint)sizeof(struct nk_font_glyph);
+    blob->key = nk_font_atlas_key(atlas, fmt);
+    blob->format = (nk_uint)fmt;
+    blob->width = (nk_uint)width;
+    blob->height = (nk_uint)height;
+    blob->glyph_count = (nk_uint)atlas->glyph_count;
+    for (i = 0; i < atlas->font_num; ++i)
+        if (!atlas->config[i].merge_mode) blob->font_count++;
+
+    #define NK_BLOB_ALIGN(x) (((x) + (NK_FONT_ATLAS_BLOB_ALIGN-1)) & ~(nk_size)(NK_FONT_ATLAS_BLOB_ALIGN-1))
+    offset = NK_BLOB_ALIGN(sizeof(struct nk_font_atlas_blob));
+    blob->font_offset = (nk_uint)offset;
+    offset += blob->font_count * sizeof(struct nk_font_atlas_blob_font);
+    blob->glyph_offset = (nk_uint)NK_BLOB_ALIGN(offset);
+    offset = blob->glyph_offset + blob->glyph_count * sizeof(struct nk_font_glyph);
+    blob->pixel_offset = (nk_uint)NK_BLOB_ALIGN(offset);
+    offset = blob->pixel_offset + (nk_size)width * (nk_size)height *
+        ((fmt == NK_FONT_ATLAS_RGBA32) ? 4: 1);
+    blob->size = (nk_uint)offset;
+    #undef NK_BLOB_ALIGN
+    return blob->size;
+}
+
+NK_API nk_size
+nk_font_atlas_save_to_memory(const struct nk_font_atlas *atlas,
+    void *memory, nk_size size)
+{
+    int i, n = 0;
+    struct nk_font_atlas_blob blob;
+    struct nk_font_atlas_blob_font *fonts;
+
+    NK_ASSERT(atlas);
+    NK_ASSERT(atlas->pixel);
+    if (!atlas || !atlas->pixel || !atlas->glyphs || atlas->cache ||
+        atlas->page_count > 1)
+        return 0;
+
+    nk_font_atlas_blob_layout(atlas, atlas->format, atlas->tex_width,
+        atlas->tex_height, &blob);
+    blob.custom[0] = atlas->custom.x; blob.custom[1] = atlas->custom.y;
+    blob.custom[2] = atlas->custom.w; blob.custom[3] = atlas->custom.h;
+    if (!memory || size < blob.size)
+        return blob.size;
+
+    nk_zero(memory, blob.size);
+    NK_MEMCPY(memory, &blob, sizeof(blob));
+    fonts = nk_ptr_add(struct nk_font_atlas_blob_font, memory, blob.font_offset);
+    for (i = 0; i < atlas->font_num; ++i) {
+        const struct nk_baked_font *baked = atlas->config[i].font;
+        if (atlas->config[i].merge_mode) continue;
+        fonts[n].height = baked->height;
+        fonts[n].ascent = baked->ascent;
+        fonts[n].descent = baked->descent;
+        fonts[n].glyph_offset = baked->glyph_offset;
+        fonts[n].glyph_count = baked->glyph_count;
+        n++;
+    }
+    NK_MEMCPY(nk_ptr_add(void, memory, blob.glyph_offset), atlas->glyphs,
+        blob.glyph_count * sizeof(struct nk_font_glyph));
+    NK_MEMCPY(nk_ptr_add(void, memory, blob.pixel_offset), atlas->pixel,
+        blob.size - blob.pixel_offset);
+    return blob.size;
+}
+
+NK_API const void*
+nk_font_atlas_load_from_memory(struct nk_font_atlas *atlas, const void *memory,
+    nk_size size, int *width, int *height, enum nk_font_atlas_format fmt)
+{
+    int i, n = 0;
+    nk_size pixel_size, bpp;
+    struct nk_font_atlas_blob blob, expected;
+    const struct nk_font_atlas_blob_font *fonts;
+
+    NK_ASSERT(atlas);
+    NK_ASSERT(width);
+    NK_ASSERT(height);
+    NK_ASSERT(atlas->temporary.alloc);
+    NK_ASSERT(atlas->temporary.free);
+    NK_ASSERT(atlas->permanent.alloc);
+    NK_ASSERT(atlas->permanent.free);
+    if (!atlas || !memory || !width || !height ||
+        !atlas->temporary.alloc || !atlas->temporary.free ||
+        !atlas->permanent.alloc || !atlas->permanent.free)
+        return 0;
+
+#ifdef NK_INCLUDE_DEFAULT_FONT
+    /* no font added so just use default font */
+    if (!atlas->font_num)
+        atlas->default_font = nk_font_atlas_add_default(atlas, 13.0f, 0);
+#endif
+    if (!atlas->font_num || size < sizeof(blob)) return 0;
+
+    /* make sure the blob was created from exactly the same input */
+    NK_MEMCPY(&blob, memory, sizeof(blob));
+    if (blob.magic != NK_FONT_ATLAS_BLOB_MAGIC || blob.version != NK_FONT_ATLAS_BLOB_VERSION)
+        return 0;
+    atlas->glyph_count = (int)blob.glyph_count;
+    nk_font_atlas_blob_layout(atlas, fmt, (int)blob.width, (int)blob.height, &expected);
+    if (blob.byte_order != expected.byte_order || blob.glyph_size != expected.glyph_size ||
+        blob.key != expected.key || blob.format != expected.format ||
+        blob.font_count != expected.font_count || blob.size != expected.size ||
+        blob.font_offset != expected.font_offset || blob.glyph_offset != expected.glyph_offset ||
+        blob.pixel_offset != expected.pixel_offset || size < blob.size) {
+        atlas->glyph_count = 0;
+        return 0;
+    }
+
+    /* the layout is stored in 32 bits so make sure no section wrapped around
+     * and all per font glyph ranges lie inside the glyph array */
+    bpp = (fmt == NK_FONT_ATLAS_RGBA32) ? 4: 1;
+    if (!blob.width || !blob.height || blob.height > size / bpp / blob.width ||
+        blob.glyph_offset > blob.pixel_offset || blob.pixel_offset > blob.size ||
+        blob.glyph_count > (blob.pixel_offset - blob.glyph_offset) / sizeof(struct nk_font_glyph) ||
+        (nk_size)blob.width * blob.height * bpp != blob.size - blob.pixel_offset) {
+        atlas->glyph_count = 0;
+        return 0;
+    }
+    fonts = nk_ptr_add_const(struct nk_font_atlas_blob_font, memory, blob.font_offset);
+    for (i = 0; i < (int)blob.font_count; ++i) {
+        if (fonts[i].glyph_offset > blob.glyph_count ||
+            fonts[i].glyph_count > blob.glyph_count - fonts[i].glyph_offset) {
+            atlas->glyph_count = 0;
+            return 0;
+        }
+    }
 
-    /* initialize each font */
-    for (i = 0; i < atlas->font_num; ++i) {
-        nk_font_init(atlas->fonts[i], atlas->config[i].size,
-            atlas->config[i].fallback_glyph, atlas->glyphs,
-            atlas->config[i].font, nk_handle_ptr(0));
+    /* copy glyphs and image */
+    pixel_size = blob.size - blob.pixel_offset;
+    atlas->glyphs = (struct nk_font_glyph*)atlas->permanent.alloc(atlas->permanent.userdata,
+        0, sizeof(struct nk_font_glyph) * blob.glyph_count);
+    atlas->pixel = atlas->temporary.alloc(atlas->temporary.userdata, 0, pixel_size);
+    NK_ASSERT(atlas->glyphs);
+    NK_ASSERT(atlas->pixel);
+    if (!atlas->glyphs || !atlas->pixel) {
+        if (atlas->glyphs) atlas->permanent.free(atlas->permanent.userdata, atlas->glyphs);
+        if (atlas->pixel) atlas->temporary.free(atlas->temporary.userdata, atlas->pixel);
+        atlas->glyphs = 0;
+        atlas->pixel = 0;
+        atlas->glyph_count = 0;
+        return 0;
     }
+    NK_MEMCPY(atlas->glyphs, nk_ptr_add_const(void, memory, blob.glyph_offset),
+        sizeof(struct nk_font_glyph) * blob.glyph_count);
+    NK_MEMCPY(atlas->pixel, nk_ptr_add_const(void, memory, blob.pixel_offset), pixel_size);
 
-    /* free temporary memory */
-    atlas->temporary.free(atlas->temporary.userdata, tmp);
+    /* restore baked font metrics */
+    for (i = 0; i < atlas->font_num; ++i) {
+        struct nk_font_config *cfg = &atlas->config[i];
+        struct nk_baked_font *baked = cfg->font;
+        if (cfg->merge_mode) continue;
+        if (!cfg->range) cfg->range = nk_font_default_glyph_ranges();
+        baked->ranges = cfg->range;
+        baked->height = fonts[n].height;
+        baked->ascent = fonts[n].ascent;
+        baked->descent = fonts[n].descent;
+        baked->sdf_spread = (float)cfg->sdf_spread;
+        baked->glyph_offset = fonts[n].glyph_offset;
+        baked->glyph_count = fonts[n].glyph_count;
+        n++;
+    }
+    atlas->custom.x = blob.custom[0]; atlas->custom.y = blob.custom[1];
+    atlas->custom.w = blob.custom[2]; atlas->custom.h = blob.custom[3];
+    atlas->tex_width = *width = (int)blob.width;
+    atlas->tex_height = *height = (int)blob.height;
+    atlas->format = fmt;
+    nk_font_atlas_init_fonts(atlas);
     return atlas->pixel;
+}
 
-failed:
-    /* error so cleanup all memory */
-    if (tmp) atlas->temporary.free(atlas->temporary.userdata, tmp);
-    if (atlas->glyphs) {
-        atlas->permanent.free(atlas->permanent.userdata, atlas->glyphs);
-        atlas->glyphs = 0;
-    }
-    if (atlas->pixel) {
-        atlas->temporary.free(atlas->temporary.userdata, atlas->pixel);
-        atlas->pixel = 0;
+#ifdef NK_INCLUDE_STANDARD_IO
+NK_API int
+nk_font_atlas_save(const struct nk_font_atlas *atlas, const char *file_path)
+{
+    FILE *fd;
+    void *memory;
+    nk_size size, written = 0;
+
+    NK_ASSERT(atlas);
+    NK_ASSERT(file_path);
+    if (!atlas || !file_path || !atlas->temporary.alloc || !atlas->temporary.free)
+        return nk_false;
+
+    size = nk_font_atlas_save_to_memory(atlas, 0, 0);
+    if (!size) return nk_false;
+    memory = atlas->temporary.alloc(atlas->temporary.userdata, 0, size);
+    NK_ASSERT(memory);
+    if (!memory) return nk_false;
+    nk_font_atlas_save_to_memory(atlas, memory, size);
+
+    fd = fopen(file_path, "wb");
+    if (fd) {
+        written = (nk_size)fwrite(memory, size, 1, fd);
+        if (fclose(fd)) written = 0;
     }
-    return 0;
+    atlas->temporary.free(atlas->temporary.userdata, memory);
+    return written == 1;
+}
+
+NK_API const void*
+nk_font_atlas_load(struct nk_font_atlas *atlas, const char *file_path,
+    int *width, int *height, enum nk_font_atlas_format fmt)
+{
+    nk_size size;
+    void *memory;
+    const void *pixel;
+
+    NK_ASSERT(atlas);
+    NK_ASSERT(file_path);
+    if (!atlas || !file_path || !atlas->temporary.alloc || !atlas->temporary.free)
+        return 0;
+
+    memory = nk_file_load(file_path, &size, &atlas->temporary);
+    if (!memory) return 0;
+    pixel = nk_font_atlas_load_from_memory(atlas, memory, size, width, height, fmt);
+    atlas->temporary.free(atlas->temporary.userdata, memory);
+    return pixel;
 }
+#endif
 
 NK_API void
 nk_font_atlas_end(struct nk_font_atlas *atlas, nk_handle texture,
     struct nk_draw_null_texture *null)
+{
+    nk_font_atlas_end_pages(atlas, &texture, 1, null);
+}
+
+NK_API void
+nk_font_atlas_end_pages(struct nk_font_atlas *atlas, const nk_handle *textures,
+    int count, struct nk_draw_null_texture *null)
 {
     int i = 0;
+    nk_handle texture;
+    NK_ASSERT(textures);
+    NK_ASSERT(count > 0);
+    if (!textures || count <= 0) return;
+
+    texture = textures[0];
     NK_ASSERT(atlas);
     if (!atlas) {
         if (!null) return;
         null->texture = texture;
         null->uv = nk_vec2(0.5f,0.5f);
     }
+    /* every page needs its own texture with the white pixel on page 0 */
+    NK_ASSERT(count >= atlas->page_count);
+    if (count < atlas->page_count) return;
     if (null) {
         null->texture = texture;
         null->uv = nk_vec2((atlas->custom.x + 0.5f)/(float)atlas->tex_width,
@@ -9882,6 +13983,12 @@ nk_font_atlas_end(struct nk_font_atlas *atlas, nk_handle texture,
         atlas->fonts[i]->handle.texture = texture;
 #endif
     }
+    for (i = 0; i < atlas->page_count; ++i) {
+        atlas->pages[i].texture = textures[i];
+        atlas->pages[i].pixel = 0;
+    }
+    /* dynamic atlas pages are kept alive for glyphs rasterized later on */
+    if (atlas->cache) return;
 
     atlas->temporary.free(atlas->temporary.userdata, atlas->pixel);
     atlas->pixel = 0;
@@ -9893,6 +14000,56 @@ nk_font_atlas_end(struct nk_font_atlas *atlas, nk_handle texture,
     atlas->custom.h = 0;
 }
 
+NK_API int
+nk_font_atlas_fallback(struct nk_font_atlas *atlas, struct nk_font *font,
+    struct nk_font *const *fallbacks, int count)
+{
+    /* all fallback chains of the atlas live inside one memory block which
+     * is rebuilt with the new chain of `font` and the existing chains */
+    int i = 0;
+    nk_size size = 0;
+    nk_byte *memory;
+    NK_ASSERT(atlas);
+    NK_ASSERT(font);
+    NK_ASSERT(atlas->permanent.alloc && atlas->permanent.free);
+    NK_ASSERT(fallbacks || !count);
+    if (!atlas || !font || !atlas->permanent.alloc || !atlas->permanent.free ||
+        (!fallbacks && count) || !atlas->font_num)
+        return nk_false;
+
+    for (i = 0; i < atlas->font_num; ++i) {
+        struct nk_font *f = atlas->fonts[i];
+        nk_size font_size = 0;
+        if (atlas->config[i].merge_mode) continue;
+        if (f == font) nk_font_fallback_memory(&font_size, f, fallbacks, count);
+        else if (f->fallbacks) nk_font_fallback_memory(&font_size, f, f->fallbacks, f->fallback_count);
+        else continue;
+        if (!font_size) return nk_false;
+        size += font_size;
+    }
+    if (!size) return nk_false;
+    memory = (nk_byte*)atlas->permanent.alloc(atlas->permanent.userdata,0, size);
+    NK_ASSERT(memory);
+    if (!memory) return nk_false;
+
+    /* existing chains are read from the old block before it is freed */
+    {nk_byte *iter = memory;
+    for (i = 0; i < atlas->font_num; ++i) {
+        struct nk_font *f = atlas->fonts[i];
+        struct nk_font *const *chain = (f == font) ? fallbacks: f->fallbacks;
+        int chain_count = (f == font) ? count: f->fallback_count;
+        nk_size font_size = 0;
+        if (atlas->config[i].merge_mode || (f != font && !f->fallbacks)) continue;
+        nk_font_fallback_memory(&font_size, f, chain, chain_count);
+        nk_font_fallback(f, chain, chain_count, iter, font_size);
+        iter += font_size;
+    }}
+    if (atlas->fallback)
+        atlas->permanent.free(atlas->permanent.userdata, atlas->fallback);
+    atlas->fallback = memory;
+    return nk_true;
+}
+
 NK_API void
 nk_font_atlas_clear(struct nk_font_atlas *atlas)
 {
@@ -9918,6 +14075,18 @@ nk_font_atlas_clear(struct nk_font_atlas *atlas)
     }
     if (atlas->glyphs)
         atlas->permanent.free(atlas->permanent.userdata, atlas->glyphs);
+    if (atlas->glyph_index)
+        atlas->permanent.free(atlas->permanent.userdata, atlas->glyph_index);
+    if (atlas->kerning)
+        atlas->permanent.free(atlas->permanent.userdata, atlas->kerning);
+    if (atlas->pages)
+        atlas->permanent.free(atlas->permanent.userdata, atlas->pages);
+    if (atlas->fallback)
+        atlas->permanent.free(atlas->permanent.userdata, atlas->fallback);
+    if (atlas->cache) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->pixel);
+        atlas->permanent.free(atlas->permanent.userdata, atlas->cache->memory);
+    }
     nk_zero_struct(*atlas);
 }
 #endif
@@ -10224,29 +14393,205 @@ NK_INTERN void nk_textedit_makeundo_insert(struct nk_text_edit*, int, int);
 NK_INTERN void nk_textedit_makeundo_replace(struct nk_text_edit*, int, int, int);
 #define NK_TEXT_HAS_SELECTION(s)   ((s)->select_start != (s)->select_end)
 
+NK_INTERN int
+nk_textedit_lines_find(const struct nk_text_edit_line *lines, int count, int pos)
+{
+    /* binary search for the last line starting at or before 'pos' */
+    int low = 0, high = count-1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (lines[mid].begin <= pos)
+            low = mid;
+        else high = mid - 1;
+    }
+    return low;
+}
+
+NK_INTERN int
+nk_textedit_lines_push(struct nk_text_edit_lines *l,
+    const struct nk_text_edit_line *line)
+{
+    NK_STORAGE const nk_size align = NK_ALIGNOF(struct nk_text_edit_line);
+    void *mem = nk_buffer_alloc(&l->buffer, NK_BUFFER_FRONT, sizeof(*line), align);
+    if (!mem) {
+        l->count = 0;
+        l->complete = 0;
+        return 0;
+    }
+    NK_MEMCPY(mem, line, sizeof(*line));
+    l->count++;
+    return 1;
+}
+
+NK_INTERN void
+nk_textedit_lines_invalidate(struct nk_text_edit *edit, int where)
+{
+    /* drops all lines behind the line containing 'where' and has to be
+     * called before the string is modified at 'where' */
+    struct nk_text_edit_lines *l = &edit->lines;
+    struct nk_text_edit_line *lines;
+    int i;
+
+    if (!l->count) return;
+    if (l->complete && l->version != edit->string.version) {
+        /* string was modified outside of the text editor */
+        l->count = 0;
+        l->complete = 0;
+        return;
+    }
+    lines = (struct nk_text_edit_line*)nk_buffer_memory(&l->buffer);
+    i = nk_textedit_lines_find(lines, l->count, where);
+    lines[i].width = -1.0f;
+    l->count = i + 1;
+    l->complete = 0;
+}
+
+NK_INTERN struct nk_text_edit_line*
+nk_textedit_lines_update(struct nk_text_edit *edit, const struct nk_user_font *font,
+    int *count)
+{
+    struct nk_text_edit_lines *l = &edit->lines;
+    struct nk_text_edit_line *lines;
+
+    NK_ASSERT(count);
+    if (l->buffer.type != NK_BUFFER_DYNAMIC || !l->buffer.pool.alloc)
+        return 0;
+    if (l->complete && l->version != edit->string.version) {
+        l->count = 0;
+        l->complete = 0;
+    }
+
+    if (!l->complete) {
+        /* index all line starts behind the last still valid line */
+        struct nk_text_edit_line line;
+        const char *text = nk_str_get_const(&edit->string);
+        int size = (int)edit->string.buffer.allocated;
+        int pos, offset;
+
+        l->buffer.allocated = (nk_size)l->count * sizeof(line);
+        if (!l->count) {
+            line.begin = 0;
+            line.offset = 0;
+            line.width = -1.0f;
+            if (!nk_textedit_lines_push(l, &line))
+                return 0;
+        } else line = ((struct nk_text_edit_line*)nk_buffer_memory(&l->buffer))[l->count-1];
+
+        pos = line.begin;
+        offset = line.offset;
+        while (text && offset < size) {
+            nk_rune unicode;
+            int glyph_len = nk_utf_decode(text + offset, &unicode, size - offset);
+            if (!glyph_len) break;
+            offset += glyph_len;
+            pos++;
+            if (unicode != '\n') continue;
+
+            line.begin = pos;
+            line.offset = offset;
+            line.width = -1.0f;
+            if (!nk_textedit_lines_push(l, &line))
+                return 0;
+        }
+        l->complete = 1;
+        l->version = edit->string.version;
+    }
+
+    lines = (struct nk_text_edit_line*)nk_buffer_memory(&l->buffer);
+    if (font && (l->font.ptr != font->userdata.ptr || l->height != font->height)) {
+        /* cached row widths are only valid for the font they were measured with */
+        int i;
+        for (i = 0; i < l->count; ++i)
+            lines[i].width = -1.0f;
+        l->font = font->userdata;
+        l->height = font->height;
+    }
+    *count = l->count;
+    return lines;
+}
+
+NK_INTERN const char*
+nk_textedit_str_at(struct nk_text_edit *edit, int pos, int *len)
+{
+    /* same as `nk_str_at_const` but only decodes from the start of the line */
+    int count;
+    nk_rune unicode;
+    const struct nk_text_edit_line *lines;
+
+    lines = nk_textedit_lines_update(edit, 0, &count);
+    if (lines && pos >= 0 && pos <= edit->string.len) {
+        const struct nk_text_edit_line *line;
+        const char *text;
+        int size, i;
+
+        line = &lines[nk_textedit_lines_find(lines, count, pos)];
+        text = (const char*)edit->string.buffer.memory.ptr + line->offset;
+        size = (int)edit->string.buffer.allocated - line->offset;
+        i = line->begin;
+        *len = nk_utf_decode(text, &unicode, size);
+        while (i < pos && *len) {
+            text += *len;
+            size -= *len;
+            *len = nk_utf_decode(text, &unicode, size);
+            i++;
+        }
+        return (i == pos) ? text: 0;
+    }
+    return nk_str_at_const(&edit->string, pos, &unicode, len);
+}
+
+NK_INTERN const char*
+nk_textedit_next_glyph(const struct nk_text_edit *edit, const char *text,
+    int *glyph_len)
+{
+    /* steps to the glyph following 'text' */
+    nk_rune unicode;
+    const char *end = (const char*)edit->string.buffer.memory.ptr +
+                        edit->string.buffer.allocated;
+    text += *glyph_len;
+    *glyph_len = nk_utf_decode(text, &unicode, (int)(end - text));
+    return text;
+}
+
 NK_INTERN float
-nk_textedit_get_width(const struct nk_text_edit *edit, int line_start, int char_id,
-    const struct nk_user_font *font)
+nk_textedit_glyph_width(const struct nk_text_edit *edit,
+    const struct nk_user_font *font, const char *text, int glyph_len)
 {
-    int len = 0;
-    nk_rune unicode = 0;
-    const char *str = nk_str_at_const(&edit->string, line_start + char_id, &unicode, &len);
-    return font->width(font->userdata, font->height, str, len);
+    /* measures the glyph at 'text' the same way rows are laid out */
+    const char *end = (const char*)edit->string.buffer.memory.ptr +
+                        edit->string.buffer.allocated;
+    return nk_text_glyph_width_at(font, text, glyph_len, (int)(end - text));
 }
 
 NK_INTERN void
 nk_textedit_layout_row(struct nk_text_edit_row *r, struct nk_text_edit *edit,
     int line_start_id, float row_height, const struct nk_user_font *font)
 {
-    int l;
+    int l, count;
     int glyphs = 0;
-    nk_rune unicode;
     const char *remaining;
+    struct nk_vec2 size;
+    struct nk_text_edit_line *line = 0;
+    struct nk_text_edit_line *lines = nk_textedit_lines_update(edit, font, &count);
     int len = nk_str_len_char(&edit->string);
     const char *end = nk_str_get_const(&edit->string) + len;
-    const char *text = nk_str_at_const(&edit->string, line_start_id, &unicode, &l);
-    const struct nk_vec2 size = nk_text_calculate_text_bounds(font,
-        text, (int)(end - text), row_height, &remaining, 0, &glyphs, NK_STOP_ON_NEW_LINE);
+    const char *text = nk_textedit_str_at(edit, line_start_id, &l);
+
+    if (lines) {
+        int i = nk_textedit_lines_find(lines, count, line_start_id);
+        if (lines[i].begin == line_start_id)
+            line = &lines[i];
+    }
+    if (line && line->width >= 0.0f) {
+        /* row width was already measured */
+        glyphs = ((line + 1 < lines + count) ? line[1].begin:
+                    edit->string.len) - line->begin;
+        size = nk_vec2(line->width, row_height);
+    } else {
+        size = nk_text_calculate_text_bounds(font, text, (int)(end - text),
+                    row_height, &remaining, 0, &glyphs, NK_STOP_ON_NEW_LINE);
+        if (line) line->width = size.x;
+    }
 
     r->x0 = 0.0f;
     r->x1 = size.x;
@@ -10263,26 +14608,43 @@ nk_textedit_locate_coord(struct nk_text_edit *edit, float x, float y,
     struct nk_text_edit_row r;
     int n = edit->string.len;
     float base_y = 0, prev_x;
-    int i=0, k;
+    int i=0, k, count;
+    int glyph_len;
+    const char *text;
+    const struct nk_text_edit_line *lines;
 
     r.x0 = r.x1 = 0;
     r.ymin = r.ymax = 0;
     r.num_chars = 0;
 
-    /* search rows to find one that straddles 'y' */
-    while (i < n) {
-        nk_textedit_layout_row(&r, edit, i, row_height, font);
-        if (r.num_chars <= 0)
+    lines = nk_textedit_lines_update(edit, font, &count);
+    if (lines && n && row_height > 0.0f) {
+        /* all rows share the same height so the row can be indexed directly */
+        int row;
+        if (y < 0) return 0;
+        if (y >= (float)count * row_height)
             return n;
+        row = (int)(y / row_height);
+        if (row >= count || lines[row].begin >= n)
+            return n;
+        i = lines[row].begin;
+        nk_textedit_layout_row(&r, edit, i, row_height, font);
+    } else {
+        /* search rows to find one that straddles 'y' */
+        while (i < n) {
+            nk_textedit_layout_row(&r, edit, i, row_height, font);
+            if (r.num_chars <= 0)
+                return n;
 
-        if (i==0 && y < base_y + r.ymin)
-            return 0;
+            if (i==0 && y < base_y + r.ymin)
+                return 0;
 
-        if (y < base_y + r.ymax)
-            break;
+            if (y < base_y + r.ymax)
+                break;
 
-        i += r.num_chars;
-        base_y += r.baseline_y_delta;
+            i += r.num_chars;
+            base_y += r.baseline_y_delta;
+        }
     }
 
     /* below all text, return 'after' last character */
@@ -10296,23 +14658,25 @@ nk_textedit_locate_coord(struct nk_text_edit *edit, float x, float y,
     /* check if it's before the end of the line */
     if (x < r.x1) {
         /* search characters in row for one that straddles 'x' */
-        k = i;
         prev_x = r.x0;
-        for (i=0; i < r.num_chars; ++i) {
-            float w = nk_textedit_get_width(edit, k, i, font);
+        text = nk_textedit_str_at(edit, i, &glyph_len);
+        for (k=0; text && k < r.num_chars; ++k) {
+            float w = nk_textedit_glyph_width(edit, font, text, glyph_len);
             if (x < prev_x+w) {
                 if (x < prev_x+w/2)
-                    return k+i;
-                else return k+i+1;
+                    return i+k;
+                else return i+k+1;
             }
             prev_x += w;
+            text = nk_textedit_next_glyph(edit, text, &glyph_len);
         }
         /* shouldn't happen, but if it does, fall through to end-of-line case */
     }
 
     /* if the last character is a newline, return that.
      * otherwise return 'after' the last character */
-    if (nk_str_rune_at(&edit->string, i+r.num_chars-1) == '\n')
+    text = nk_textedit_str_at(edit, i+r.num_chars-1, &glyph_len);
+    if (text && glyph_len && *text == '\n')
         return i+r.num_chars-1;
     else return i+r.num_chars;
 }
@@ -10350,8 +14714,11 @@ nk_textedit_find_charpos(struct nk_text_find *find, struct nk_text_edit *state,
     struct nk_text_edit_row r;
     int prev_start = 0;
     int z = state->string.len;
-    int i=0, first;
+    int i=0, first, count, glyph_len;
+    const char *text;
+    const struct nk_text_edit_line *lines;
 
+    lines = nk_textedit_lines_update(state, font, &count);
     if (n == z) {
         /* if it's at the end, then find the last line -- simpler than trying to
         explicitly handle this case in the regular code */
@@ -10367,10 +14734,16 @@ nk_textedit_find_charpos(struct nk_text_find *find, struct nk_text_edit *state,
             find->x = 0;
             find->height = 1;
 
-            while (i < z) {
-                nk_textedit_layout_row(&r, state, i, row_height, font);
-                prev_start = i;
-                i += r.num_chars;
+            if (lines) {
+                /* last row is the line containing the last character */
+                if (z) prev_start = lines[nk_textedit_lines_find(lines, count, z-1)].begin;
+                i = z;
+            } else {
+                while (i < z) {
+                    nk_textedit_layout_row(&r, state, i, row_height, font);
+                    prev_start = i;
+                    i += r.num_chars;
+                }
             }
 
             find->first_char = i;
@@ -10382,13 +14755,20 @@ nk_textedit_find_charpos(struct nk_text_find *find, struct nk_text_edit *state,
 
     /* search rows to find the one that straddles character n */
     find->y = 0;
-
-    for(;;) {
+    if (lines) {
+        int row = nk_textedit_lines_find(lines, count, n);
+        if (row) prev_start = lines[row-1].begin;
+        i = lines[row].begin;
+        find->y = (float)row * row_height;
         nk_textedit_layout_row(&r, state, i, row_height, font);
-        if (n < i + r.num_chars) break;
-        prev_start = i;
-        i += r.num_chars;
-        find->y += r.baseline_y_delta;
+    } else {
+        for(;;) {
+            nk_textedit_layout_row(&r, state, i, row_height, font);
+            if (n < i + r.num_chars) break;
+            prev_start = i;
+            i += r.num_chars;
+            find->y += r.baseline_y_delta;
+        }
     }
 
     find->first_char = first = i;
@@ -10398,8 +14778,11 @@ nk_textedit_find_charpos(struct nk_text_find *find, struct nk_text_edit *state,
 
     /* now scan to find xpos */
     find->x = r.x0;
-    for (i=0; first+i < n; ++i)
-        find->x += nk_textedit_get_width(state, first, i, font);
+    text = nk_textedit_str_at(state, first, &glyph_len);
+    for (i=0; text && first+i < n; ++i) {
+        find->x += nk_textedit_glyph_width(state, font, text, glyph_len);
+        text = nk_textedit_next_glyph(state, text, &glyph_len);
+    }
 }
 
 NK_INTERN void
@@ -10422,6 +14805,7 @@ nk_textedit_delete(struct nk_text_edit *state, int where, int len)
 {
     /* delete characters while updating undo */
     nk_textedit_makeundo_delete(state, where, len);
+    nk_textedit_lines_invalidate(state, where);
     nk_str_delete_runes(&state->string, where, len);
     state->has_preferred_x = 0;
 }
@@ -10552,6 +14936,7 @@ nk_textedit_paste(struct nk_text_edit *state, char const *ctext, int len)
     nk_textedit_delete_selection(state);
     /* try to insert the characters */
     glyphs = nk_utf_len(ctext, len);
+    nk_textedit_lines_invalidate(state, state->cursor);
     if (nk_str_insert_text_char(&state->string, state->cursor, text, len)) {
         nk_textedit_makeundo_insert(state, state->cursor, glyphs);
         state->cursor += len;
@@ -10595,8 +14980,10 @@ nk_textedit_text(struct nk_text_edit *state, const char *text, int total_len)
         {
             if (state->mode == NK_TEXT_EDIT_MODE_REPLACE) {
                 nk_textedit_makeundo_replace(state, state->cursor, 1, 1);
+                nk_textedit_lines_invalidate(state, state->cursor);
                 nk_str_delete_runes(&state->string, state->cursor, 1);
             }
+            nk_textedit_lines_invalidate(state, state->cursor);
             if (nk_str_insert_text_char(&state->string, state->cursor,
                                         text+text_len, glyph_len))
             {
@@ -10605,6 +14992,7 @@ nk_textedit_text(struct nk_text_edit *state, const char *text, int total_len)
             }
         } else {
             nk_textedit_delete_selection(state); /* implicitly clamps */
+            nk_textedit_lines_invalidate(state, state->cursor);
             if (nk_str_insert_text_char(&state->string, state->cursor,
                                         text+text_len, glyph_len))
             {
@@ -10731,7 +15119,8 @@ retry:
     case NK_KEY_DOWN: {
         struct nk_text_find find;
         struct nk_text_edit_row row;
-        int i, sel = shift_mod;
+        int i, glyph_len, sel = shift_mod;
+        const char *text;
 
         if (state->single_line) {
             /* on windows, up&down in single-line behave like left&right */
@@ -10760,12 +15149,14 @@ retry:
             nk_textedit_layout_row(&row, state, state->cursor, row_height, font);
             x = row.x0;
 
-            for (i=0; i < row.num_chars; ++i) {
-                float dx = nk_textedit_get_width(state, start, i, font);
+            text = nk_textedit_str_at(state, start, &glyph_len);
+            for (i=0; text && i < row.num_chars; ++i) {
+                float dx = nk_textedit_glyph_width(state, font, text, glyph_len);
                 x += dx;
                 if (x > goal_x)
                     break;
                 ++state->cursor;
+                text = nk_textedit_next_glyph(state, text, &glyph_len);
             }
             nk_textedit_clamp(state);
 
@@ -10779,7 +15170,8 @@ retry:
     case NK_KEY_UP: {
         struct nk_text_find find;
         struct nk_text_edit_row row;
-        int i, sel = shift_mod;
+        int i, glyph_len, sel = shift_mod;
+        const char *text;
 
         if (state->single_line) {
             /* on windows, up&down become left&right */
@@ -10807,12 +15199,14 @@ retry:
             nk_textedit_layout_row(&row, state, state->cursor, row_height, font);
             x = row.x0;
 
-            for (i=0; i < row.num_chars; ++i) {
-                float dx = nk_textedit_get_width(state, find.prev_first, i, font);
+            text = nk_textedit_str_at(state, find.prev_first, &glyph_len);
+            for (i=0; text && i < row.num_chars; ++i) {
+                float dx = nk_textedit_glyph_width(state, font, text, glyph_len);
                 x += dx;
                 if (x > goal_x)
                     break;
                 ++state->cursor;
+                text = nk_textedit_next_glyph(state, text, &glyph_len);
             }
             nk_textedit_clamp(state);
 
@@ -11047,6 +15441,7 @@ nk_textedit_undo(struct nk_text_edit *state)
     r->insert_length = u.delete_length;
     r->delete_length = u.insert_length;
     r->where = u.where;
+    nk_textedit_lines_invalidate(state, u.where);
 
     if (u.delete_length)
     {
@@ -11117,6 +15512,7 @@ nk_textedit_redo(struct nk_text_edit *state)
     u->insert_length = r.delete_length;
     u->where = r.where;
     u->char_storage = -1;
+    nk_textedit_lines_invalidate(state, r.where);
 
     if (r.delete_length) {
         /* the redo record requires us to delete characters, so the undo record
@@ -11196,6 +15592,8 @@ nk_textedit_clear_state(struct nk_text_edit *state, enum nk_text_edit_type type,
    state->single_line = (unsigned char)(type == NK_TEXT_EDIT_SINGLE_LINE);
    state->mode = NK_TEXT_EDIT_MODE_VIEW;
    state->filter = filter;
+   state->lines.count = 0;
+   state->lines.complete = 0;
 }
 
 NK_API void
@@ -11206,6 +15604,7 @@ nk_textedit_init_fixed(struct nk_text_edit *state, void *memory, nk_size size)
     if (!state || !memory || !size) return;
     nk_textedit_clear_state(state, NK_TEXT_EDIT_SINGLE_LINE, 0);
     nk_str_init_fixed(&state->string, memory, size);
+    nk_zero(&state->lines, sizeof(state->lines));
 }
 
 NK_API void
@@ -11216,6 +15615,7 @@ nk_textedit_init(struct nk_text_edit *state, struct nk_allocator *alloc, nk_size
     if (!state || !alloc) return;
     nk_textedit_clear_state(state, NK_TEXT_EDIT_SINGLE_LINE, 0);
     nk_str_init(&state->string, alloc, size);
+    nk_buffer_init(&state->lines.buffer, alloc, NK_TEXTEDIT_LINE_INITIAL_SIZE);
 }
 
 #ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
@@ -11226,6 +15626,7 @@ nk_textedit_init_default(struct nk_text_edit *state)
     if (!state) return;
     nk_textedit_clear_state(state, NK_TEXT_EDIT_SINGLE_LINE, 0);
     nk_str_init_default(&state->string);
+    nk_buffer_init_default(&state->lines.buffer);
 }
 #endif
 
@@ -11243,6 +15644,7 @@ nk_textedit_free(struct nk_text_edit *state)
     NK_ASSERT(state);
     if (!state) return;
     nk_str_free(&state->string);
+    nk_buffer_free(&state->lines.buffer);
 }
 
 /* ===============================================================
@@ -11278,7 +15680,7 @@ nk_widget_text(struct nk_command_buffer *o, struct nk_rect b,
     label.y = b.y + t->padding.y;
     label.h = b.h - 2 * t->padding.y;
 
-    text_width = f->width(f->userdata, f->height, (const char*)string, len);
+    text_width = nk_text_width(o->text_cache, f, (const char*)string, len);
     text_width += (2.0f * t->padding.x);
 
     /* align in x-axis */
@@ -11337,13 +15739,13 @@ nk_widget_text_wrap(struct nk_command_buffer *o, struct nk_rect b,
     line.w = b.w - 2 * t->padding.x;
     line.h = 2 * t->padding.y + f->height;
 
-    fitting = nk_text_clamp(f, string, len, line.w, &glyphs, &width);
+    fitting = nk_text_clamp(o->text_cache, f, string, len, line.w, &glyphs, &width);
     while (done < len) {
         if (!fitting || line.y + line.h >= (b.y + b.h)) break;
         nk_widget_text(o, line, &string[done], fitting, &text, NK_TEXT_LEFT, f);
         done += fitting;
         line.y += f->height + 2 * t->padding.y;
-        fitting = nk_text_clamp(f, &string[done], len - done,
+        fitting = nk_text_clamp(o->text_cache, f, &string[done], len - done,
                                 line.w, &glyphs, &width);
     }
 }
@@ -12731,7 +17133,8 @@ nk_edit_draw_text(struct nk_command_buffer *out,
             glyph_len = nk_utf_decode(text + text_len, &unicode, byte_len-text_len);
             continue;
         }
-        glyph_width = font->width(font->userdata, font->height, text+text_len, glyph_len);
+        glyph_width = nk_text_glyph_width_at(font, text+text_len, glyph_len,
+                        byte_len-text_len);
         line_width += (float)glyph_width;
         text_len += glyph_len;
         glyph_len = nk_utf_decode(text + text_len, &unicode, byte_len-text_len);
@@ -12754,6 +17157,67 @@ nk_edit_draw_text(struct nk_command_buffer *out,
     }}
 }
 
+NK_INTERN void
+nk_edit_draw_visible_text(struct nk_command_buffer *out,
+    const struct nk_style_edit *style, float pos_x, float pos_y,
+    struct nk_vec2 offset, const char *text, int byte_len,
+    const char *visible_begin, const char *visible_end, float visible_y,
+    float row_height, const struct nk_user_font *font, struct nk_color background,
+    struct nk_color foreground, int is_selected)
+{
+    /* only draws the part of the text inside the visible rows which start at
+     * line `visible_begin` with row offset `visible_y` */
+    const char *end = text + byte_len;
+    if (!text || !byte_len) return;
+    if (text < visible_begin) {
+        text = visible_begin;
+        offset = nk_vec2(0, visible_y);
+    }
+    if (end > visible_end)
+        end = visible_end;
+    if (text >= end) return;
+    nk_edit_draw_text(out, style, pos_x, pos_y + offset.y, offset.x, text,
+        (int)(end - text), row_height, font, background, foreground, is_selected);
+}
+
+NK_INTERN float
+nk_edit_visible_rows(const struct nk_text_edit *edit,
+    const struct nk_text_edit_line *lines, int count, float scroll_y,
+    float height, float row_height, const char **begin, const char **end)
+{
+    /* byte range of all rows intersecting the visible area */
+    const char *text = (const char*)edit->string.buffer.memory.ptr;
+    int first, last;
+    if (row_height <= 0.0f) return 0;
+    first = (int)NK_CLAMP(0.0f, scroll_y / row_height, (float)(count-1));
+    last = (int)NK_CLAMP(0.0f, (scroll_y + height) / row_height, (float)(count-1));
+    *begin = text + lines[first].offset;
+    *end = (last + 1 < count) ? text + lines[last+1].offset:
+        text + edit->string.buffer.allocated;
+    return (float)first * row_height;
+}
+
+NK_INTERN struct nk_vec2
+nk_edit_text_position(struct nk_text_edit *edit,
+    const struct nk_text_edit_line *lines, int count, int pos,
+    float row_height, const struct nk_user_font *font, const char **at)
+{
+    /* calculates the 2D position of a rune from the line index */
+    int glyph_len;
+    struct nk_vec2 position;
+    const char *begin, *end;
+    int row;
+
+    row = nk_textedit_lines_find(lines, count, pos);
+    begin = (const char*)edit->string.buffer.memory.ptr + lines[row].offset;
+    end = (const char*)edit->string.buffer.memory.ptr + edit->string.buffer.allocated;
+    *at = nk_textedit_str_at(edit, pos, &glyph_len);
+    position.y = (float)row * row_height;
+    position.x = (*at) ? nk_text_prefix_width(font, begin, (int)(*at - begin),
+                (int)(end - begin)): 0;
+    return position;
+}
+
 NK_INTERN nk_flags
 nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
     struct nk_rect bounds, nk_flags flags, nk_filter filter,
@@ -12918,6 +17382,14 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
     const char *text = nk_str_get_const(&edit->string);
     int len = nk_str_len_char(&edit->string);
 
+    /* multi-line text with a line index only processes visible rows */
+    int line_count = 0;
+    const struct nk_text_edit_line *lines = (flags & NK_EDIT_MULTILINE && text && len) ?
+        nk_textedit_lines_update(edit, font, &line_count): 0;
+    const char *visible_begin = text;
+    const char *visible_end = text + len;
+    float visible_y = 0;
+
     {/* select background colors/images  */
     const struct nk_style_item *background;
     if (*state & NK_WIDGET_STATE_ACTIVED)
@@ -12956,10 +17428,31 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
 
         /* calculate total line count + total space + cursor/selection position */
         float line_width = 0.0f;
-        if (text && len)
+        if (lines)
+        {
+            /* look up positions in the line index */
+            const char *at;
+            total_lines = line_count;
+            text_size.y = (float)total_lines * row_height;
+            cursor_pos = nk_edit_text_position(edit, lines, line_count,
+                edit->cursor, row_height, font, &at);
+            if (edit->cursor < edit->string.len)
+                cursor_ptr = at;
+
+            if (edit->select_start != edit->select_end) {
+                selection_offset_start = nk_edit_text_position(edit, lines,
+                    line_count, selection_begin, row_height, font, &at);
+                if (selection_begin < edit->string.len)
+                    select_begin_ptr = at;
+                selection_offset_end = nk_edit_text_position(edit, lines,
+                    line_count, selection_end, row_height, font, &at);
+                if (selection_end < edit->string.len)
+                    select_end_ptr = at;
+            }
+        }
+        else if (text && len)
         {
             /* utf8 encoding */
-            float glyph_width;
             int glyph_len = 0;
             nk_rune unicode = 0;
             int text_len = 0;
@@ -12967,7 +17460,6 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
             int row_begin = 0;
 
             glyph_len = nk_utf_decode(text, &unicode, len);
-            glyph_width = font->width(font->userdata, font->height, text, glyph_len);
             line_width = 0;
 
             /* iterate all lines */
@@ -12976,17 +17468,10 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
                 /* set cursor 2D position and line */
                 if (!cursor_ptr && glyphs == edit->cursor)
                 {
-                    int glyph_offset;
-                    struct nk_vec2 out_offset;
-                    struct nk_vec2 row_size;
-                    const char *remaining;
-
                     /* calculate 2d position */
                     cursor_pos.y = (float)(total_lines-1) * row_height;
-                    row_size = nk_text_calculate_text_bounds(font, text+row_begin,
-                                text_len-row_begin, row_height, &remaining,
-                                &out_offset, &glyph_offset, NK_STOP_ON_NEW_LINE);
-                    cursor_pos.x = row_size.x;
+                    cursor_pos.x = nk_text_prefix_width(font, text+row_begin,
+                                text_len-row_begin, len-row_begin);
                     cursor_ptr = text + text_len;
                 }
 
@@ -12994,17 +17479,10 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
                 if (!select_begin_ptr && edit->select_start != edit->select_end &&
                     glyphs == selection_begin)
                 {
-                    int glyph_offset;
-                    struct nk_vec2 out_offset;
-                    struct nk_vec2 row_size;
-                    const char *remaining;
-
                     /* calculate 2d position */
                     selection_offset_start.y = (float)(total_lines-1) * row_height;
-                    row_size = nk_text_calculate_text_bounds(font, text+row_begin,
-                                text_len-row_begin, row_height, &remaining,
-                                &out_offset, &glyph_offset, NK_STOP_ON_NEW_LINE);
-                    selection_offset_start.x = row_size.x;
+                    selection_offset_start.x = nk_text_prefix_width(font, text+row_begin,
+                                text_len-row_begin, len-row_begin);
                     select_begin_ptr = text + text_len;
                 }
 
@@ -13012,17 +17490,10 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
                 if (!select_end_ptr && edit->select_start != edit->select_end &&
                     glyphs == selection_end)
                 {
-                    int glyph_offset;
-                    struct nk_vec2 out_offset;
-                    struct nk_vec2 row_size;
-                    const char *remaining;
-
                     /* calculate 2d position */
                     selection_offset_end.y = (float)(total_lines-1) * row_height;
-                    row_size = nk_text_calculate_text_bounds(font, text+row_begin,
-                                text_len-row_begin, row_height, &remaining,
-                                &out_offset, &glyph_offset, NK_STOP_ON_NEW_LINE);
-                    selection_offset_end.x = row_size.x;
+                    selection_offset_end.x = nk_text_prefix_width(font, text+row_begin,
+                                text_len-row_begin, len-row_begin);
                     select_end_ptr = text + text_len;
                 }
                 if (unicode == '\n') {
@@ -13037,11 +17508,10 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
                 }
 
                 glyphs++;
+                if (unicode != '\r')
+                    line_width += nk_text_glyph_width_at(font, text+text_len,
+                                    glyph_len, len-text_len);
                 text_len += glyph_len;
-                line_width += (float)glyph_width;
-
-                glyph_width = font->width(font->userdata, font->height,
-                    text+text_len, glyph_len);
                 glyph_len = nk_utf_decode(text + text_len, &unicode, len-text_len);
                 continue;
             }
@@ -13097,6 +17567,10 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
                     scroll_offset, scroll_target, scroll_step, scroll_inc,
                     &style->scrollbar, in, font);}
         }
+        if (lines) {
+            visible_y = nk_edit_visible_rows(edit, lines, line_count,
+                edit->scrollbar.y, area.h, row_height, &visible_begin, &visible_end);
+        }
 
         /* draw text */
         {struct nk_color background_color;
@@ -13139,8 +17613,9 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
             /* no selection so just draw the complete text */
             const char *begin = nk_str_get_const(&edit->string);
             int l = nk_str_len_char(&edit->string);
-            nk_edit_draw_text(out, style, area.x - edit->scrollbar.x,
-                area.y - edit->scrollbar.y, 0, begin, l, row_height, font, 
+            nk_edit_draw_visible_text(out, style, area.x - edit->scrollbar.x,
+                area.y - edit->scrollbar.y, nk_vec2(0,0), begin, l,
+                visible_begin, visible_end, visible_y, row_height, font,
                 background_color, text_color, nk_false);
         } else {
             /* edit has selection so draw 1-3 text chunks */
@@ -13148,9 +17623,10 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
                 /* draw unselected text before selection */
                 const char *begin = nk_str_get_const(&edit->string);
                 NK_ASSERT(select_begin_ptr);
-                nk_edit_draw_text(out, style, area.x - edit->scrollbar.x,
-                    area.y - edit->scrollbar.y, 0, begin, (int)(select_begin_ptr - begin),
-                    row_height, font, background_color, text_color, nk_false);
+                nk_edit_draw_visible_text(out, style, area.x - edit->scrollbar.x,
+                    area.y - edit->scrollbar.y, nk_vec2(0,0), begin,
+                    (int)(select_begin_ptr - begin), visible_begin, visible_end,
+                    visible_y, row_height, font, background_color, text_color, nk_false);
             }
             if (edit->select_start != edit->select_end) {
                 /* draw selected text */
@@ -13159,12 +17635,12 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
                     const char *begin = nk_str_get_const(&edit->string);
                     select_end_ptr = begin + nk_str_len_char(&edit->string);
                 }
-                nk_edit_draw_text(out, style,
-                    area.x - edit->scrollbar.x,
-                    area.y + selection_offset_start.y - edit->scrollbar.y,
-                    selection_offset_start.x,
-                    select_begin_ptr, (int)(select_end_ptr - select_begin_ptr),
-                    row_height, font, sel_background_color, sel_text_color, nk_true);
+                nk_edit_draw_visible_text(out, style,
+                    area.x - edit->scrollbar.x, area.y - edit->scrollbar.y,
+                    selection_offset_start, select_begin_ptr,
+                    (int)(select_end_ptr - select_begin_ptr), visible_begin,
+                    visible_end, visible_y, row_height, font,
+                    sel_background_color, sel_text_color, nk_true);
             }
             if ((edit->select_start != edit->select_end &&
                 selection_end < edit->string.len))
@@ -13174,11 +17650,10 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
                 const char *end = nk_str_get_const(&edit->string) +
                                     nk_str_len_char(&edit->string);
                 NK_ASSERT(select_end_ptr);
-                nk_edit_draw_text(out, style,
-                    area.x - edit->scrollbar.x,
-                    area.y + selection_offset_end.y - edit->scrollbar.y,
-                    selection_offset_end.x,
-                    begin, (int)(end - begin), row_height, font,
+                nk_edit_draw_visible_text(out, style,
+                    area.x - edit->scrollbar.x, area.y - edit->scrollbar.y,
+                    selection_offset_end, begin, (int)(end - begin),
+                    visible_begin, visible_end, visible_y, row_height, font,
                     background_color, text_color, nk_true);
             }
         }
@@ -13208,7 +17683,8 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
 
                 label.x = area.x + cursor_pos.x - edit->scrollbar.x;
                 label.y = area.y + cursor_pos.y - edit->scrollbar.y;
-                label.w = font->width(font->userdata, font->height, cursor_ptr, glyph_len);
+                label.w = nk_text_glyph_width_at(font, cursor_ptr, glyph_len,
+                            (int)((text + len) - cursor_ptr));
                 label.h = row_height;
 
                 txt.padding = nk_vec2(0,0);
@@ -13239,9 +17715,14 @@ nk_do_edit(nk_flags *state, struct nk_command_buffer *out,
         if (background->type == NK_STYLE_ITEM_IMAGE)
             background_color = nk_rgba(0,0,0,0);
         else background_color = background->data.color;
-        nk_edit_draw_text(out, style, area.x - edit->scrollbar.x,
-            area.y - edit->scrollbar.y, 0, begin, l, row_height, font,
-            background_color, text_color, nk_false);
+        if (lines) {
+            visible_y = nk_edit_visible_rows(edit, lines, line_count,
+                edit->scrollbar.y, area.h, row_height, &visible_begin, &visible_end);
+        }
+        nk_edit_draw_visible_text(out, style, area.x - edit->scrollbar.x,
+            area.y - edit->scrollbar.y, nk_vec2(0,0), begin, l, visible_begin,
+            visible_end, visible_y, row_height, font, background_color,
+            text_color, nk_false);
     }
     nk_push_scissor(out, old_clip);}
     return ret;
@@ -13392,7 +17873,7 @@ nk_do_property(nk_flags *ws,
 
     /* text label */
     name_len = nk_strlen(name);
-    size = font->width(font->userdata, font->height, name, name_len);
+    size = nk_text_width(out->text_cache, font, name, name_len);
     label.x = left.x + left.w + style->padding.x;
     label.w = (float)size + 2 * style->padding.x;
     label.y = property.y + style->border + style->padding.y;
@@ -14248,12 +18729,20 @@ nk_style_set_font(struct nk_context *ctx, const struct nk_user_font *font)
  *                          POOL
  *
  * ===============================================================*/
-#define NK_VALUE_PAGE_CAPACITY ((sizeof(struct nk_window) / sizeof(nk_uint)) / 2)
+/* window state tables form a hash trie: each page is a small open addressed
+ * table and keys that do not fit are passed down to one of its child pages
+ * selected by the next four bits of the key. Values never move once added. */
+#define NK_VALUE_PAGE_CHILDREN 16
+#define NK_VALUE_PAGE_CAPACITY (((sizeof(struct nk_window) -\
+    NK_VALUE_PAGE_CHILDREN * sizeof(void*)) / sizeof(nk_uint)) / 2)
+#define NK_VALUE_PAGE_LOAD ((NK_VALUE_PAGE_CAPACITY * 3) / 4)
 struct nk_table {
     unsigned int seq;
+    unsigned int size;
+    nk_uint used[(NK_VALUE_PAGE_CAPACITY + 31) / 32];
     nk_hash keys[NK_VALUE_PAGE_CAPACITY];
     nk_uint values[NK_VALUE_PAGE_CAPACITY];
-    struct nk_table *next, *prev;
+    struct nk_table *next[NK_VALUE_PAGE_CHILDREN];
 };
 
 union nk_page_data {
@@ -14273,6 +18762,11 @@ struct nk_page {
     struct nk_page_element win[1];
 };
 
+struct nk_window_slot {
+    nk_hash name;
+    struct nk_window *win;
+};
+
 struct nk_pool {
     struct nk_allocator alloc;
     enum nk_allocation_type type;
@@ -14282,6 +18776,10 @@ struct nk_pool {
     unsigned capacity;
     nk_size size;
     nk_size cap;
+    /* open addressed window name hash map (dynamic pools only) */
+    struct nk_window_slot *windows;
+    unsigned int window_capacity;
+    unsigned int window_count;
 };
 
 NK_INTERN void
@@ -14302,6 +18800,8 @@ nk_pool_free(struct nk_pool *pool)
     struct nk_page *iter = pool->pages;
     if (!pool) return;
     if (pool->type == NK_BUFFER_FIXED) return;
+    if (pool->windows)
+        pool->alloc.free(pool->alloc.userdata, pool->windows);
     while (iter) {
         next = iter->next;
         pool->alloc.free(pool->alloc.userdata, iter);
@@ -14354,8 +18854,8 @@ nk_pool_alloc(struct nk_pool *pool)
 NK_INTERN void* nk_create_window(struct nk_context *ctx);
 NK_INTERN void nk_remove_window(struct nk_context*, struct nk_window*);
 NK_INTERN void nk_free_window(struct nk_context *ctx, struct nk_window *win);
-NK_INTERN void nk_free_table(struct nk_context *ctx, struct nk_table *tbl);
-NK_INTERN void nk_remove_table(struct nk_window *win, struct nk_table *tbl);
+NK_INTERN void nk_free_tables(struct nk_context *ctx, struct nk_window *win,
+    struct nk_table **tbl, int unused_only);
 
 NK_INTERN void
 nk_setup(struct nk_context *ctx, const struct nk_user_font *font)
@@ -14364,6 +18864,10 @@ nk_setup(struct nk_context *ctx, const struct nk_user_font *font)
     if (!ctx) return;
 
     nk_zero_struct(*ctx);
+#if NK_TEXT_CACHE_CAPACITY > 0
+    NK_ASSERT(NK_TEXT_CACHE_CAPACITY >= NK_TEXT_CACHE_WAYS);
+    NK_ASSERT((NK_TEXT_CACHE_CAPACITY & (NK_TEXT_CACHE_CAPACITY-1)) == 0);
+#endif
     nk_style_default(ctx);
     if (font) ctx->style.font = *font;
 #ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
@@ -14426,10 +18930,14 @@ NK_API int
 nk_init(struct nk_context *ctx, struct nk_allocator *alloc,
     const struct nk_user_font *font)
 {
+    int i;
     NK_ASSERT(alloc);
     if (!alloc) return 0;
     nk_setup(ctx, font);
     nk_buffer_init(&ctx->memory, alloc, NK_DEFAULT_COMMAND_BUFFER_SIZE);
+    nk_buffer_init(&ctx->text_edit.lines.buffer, alloc, NK_TEXTEDIT_LINE_INITIAL_SIZE);
+    for (i = 0; i < NK_EDIT_LINES_CACHE; ++i)
+        nk_buffer_init(&ctx->edit_lines[i].lines.buffer, alloc, NK_TEXTEDIT_LINE_INITIAL_SIZE);
     ctx->pool = alloc->alloc(alloc->userdata,0, sizeof(struct nk_pool));
     nk_pool_init((struct nk_pool*)ctx->pool, alloc, NK_POOL_DEFAULT_CAPACITY);
     return 1;
@@ -14449,9 +18957,13 @@ nk_set_user_data(struct nk_context *ctx, nk_handle handle)
 NK_API void
 nk_free(struct nk_context *ctx)
 {
+    int i;
     NK_ASSERT(ctx);
     if (!ctx) return;
     nk_buffer_free(&ctx->memory);
+    nk_buffer_free(&ctx->text_edit.lines.buffer);
+    for (i = 0; i < NK_EDIT_LINES_CACHE; ++i)
+        nk_buffer_free(&ctx->edit_lines[i].lines.buffer);
     if (ctx->pool) {
         struct nk_pool *pool = (struct nk_pool*)ctx->pool;
         nk_pool_free(pool);
@@ -14461,6 +18973,8 @@ nk_free(struct nk_context *ctx)
     nk_zero(&ctx->input, sizeof(ctx->input));
     nk_zero(&ctx->style, sizeof(ctx->style));
     nk_zero(&ctx->memory, sizeof(ctx->memory));
+    nk_zero(&ctx->text_edit.lines, sizeof(ctx->text_edit.lines));
+    nk_zero(ctx->edit_lines, sizeof(ctx->edit_lines));
 
     ctx->seq = 0;
     ctx->pool = 0;
@@ -14473,6 +18987,19 @@ nk_free(struct nk_context *ctx)
     ctx->count = 0;
 }
 
+NK_API void
+nk_text_cache_clear(struct nk_context *ctx)
+{
+    /* has to be called if a font returns different widths for the same
+     * userdata and height, for example after it has been rebuilt or its
+     * fallback chain changed with `nk_font_fallback` */
+    NK_ASSERT(ctx);
+    if (!ctx) return;
+#if NK_TEXT_CACHE_CAPACITY > 0
+    nk_zero_struct(ctx->text_cache);
+#endif
+}
+
 NK_API void
 nk_clear(struct nk_context *ctx)
 {
@@ -14507,19 +19034,8 @@ nk_clear(struct nk_context *ctx)
             iter->popup.win = 0;
         }
 
-        {struct nk_table *n, *it = iter->tables;
-        while (it) {
-            /* remove unused window state tables */
-            n = it->next;
-            if (it->seq != ctx->seq) {
-                nk_remove_table(iter, it);
-                nk_zero(it, sizeof(union nk_page_data));
-                nk_free_table(ctx, it);
-                if (it == iter->tables)
-                    iter->tables = n;
-            }
-            it = n;
-        }}
+        /* remove unused window state tables */
+        nk_free_tables(ctx, iter, &iter->tables, nk_true);
 
         /* window itself is not used anymore so free */
         if (iter->seq != ctx->seq || iter->flags & NK_WINDOW_HIDDEN) {
@@ -14752,66 +19268,77 @@ nk_free_table(struct nk_context *ctx, struct nk_table *tbl)
 }
 
 NK_INTERN void
-nk_push_table(struct nk_window *win, struct nk_table *tbl)
-{
-    if (!win->tables) {
-        win->tables = tbl;
-        tbl->next = 0;
-        tbl->prev = 0;
-        win->table_count = 1;
-        win->table_size = 1;
+nk_free_tables(struct nk_context *ctx, struct nk_window *win,
+    struct nk_table **tbl, int unused_only)
+{
+    int i, leaf = nk_true;
+    struct nk_table *it = *tbl;
+    if (!it) return;
+    for (i = 0; i < NK_VALUE_PAGE_CHILDREN; ++i) {
+        nk_free_tables(ctx, win, &it->next[i], unused_only);
+        if (it->next[i]) leaf = nk_false;
+    }
+    /* pages with child pages are still needed to reach them */
+    if (!leaf || (unused_only && it->seq == ctx->seq))
         return;
-    }
-    win->tables->prev = tbl;
-    tbl->next = win->tables;
-    tbl->prev = 0;
-    win->tables = tbl;
-    win->table_count++;
-    win->table_size = 0;
-}
-
-NK_INTERN void
-nk_remove_table(struct nk_window *win, struct nk_table *tbl)
-{
-    if (win->tables == tbl)
-        win->tables = tbl->next;
-    if (tbl->next)
-        tbl->next->prev = tbl->prev;
-    if (tbl->prev)
-        tbl->prev->next = tbl->next;
-    tbl->next = 0;
-    tbl->prev = 0;
+    win->table_count--;
+    win->table_size -= it->size;
+    nk_zero(it, sizeof(union nk_page_data));
+    nk_free_table(ctx, it);
+    *tbl = 0;
 }
 
 NK_INTERN nk_uint*
 nk_add_value(struct nk_context *ctx, struct nk_window *win,
             nk_hash name, nk_uint value)
 {
-    if (!win->tables || win->table_size == NK_VALUE_PAGE_CAPACITY) {
-        struct nk_table *tbl = nk_create_table(ctx);
-        nk_push_table(win, tbl);
+    unsigned int shift = 0;
+    struct nk_table **link = &win->tables;
+    while (shift < sizeof(nk_hash) * 8) {
+        struct nk_table *tbl = *link;
+        if (!tbl) {
+            tbl = nk_create_table(ctx);
+            NK_ASSERT(tbl);
+            if (!tbl) return 0;
+            *link = tbl;
+            win->table_count++;
+        }
+        if (tbl->size < NK_VALUE_PAGE_LOAD) {
+            /* linear probe for a free slot inside the page */
+            nk_uint i = (nk_uint)((name >> shift) % NK_VALUE_PAGE_CAPACITY);
+            while (tbl->used[i/32] & (1u << (i % 32)))
+                i = (nk_uint)((i + 1) % NK_VALUE_PAGE_CAPACITY);
+            tbl->used[i/32] |= (1u << (i % 32));
+            tbl->keys[i] = name;
+            tbl->values[i] = value;
+            tbl->seq = win->seq;
+            tbl->size++;
+            win->table_size++;
+            return &tbl->values[i];
+        }
+        link = &tbl->next[(name >> shift) % NK_VALUE_PAGE_CHILDREN];
+        shift += 4;
     }
-    win->tables->seq = win->seq;
-    win->tables->keys[win->table_size] = name;
-    win->tables->values[win->table_size] = value;
-    return &win->tables->values[win->table_size++];
+    NK_ASSERT(0 && "window state table depth exceeded");
+    return 0;
 }
 
 NK_INTERN nk_uint*
 nk_find_value(struct nk_window *win, nk_hash name)
 {
-    unsigned short size = win->table_size;
+    unsigned int shift = 0;
     struct nk_table *iter = win->tables;
     while (iter) {
-        unsigned short i = 0;
-        for (i = 0; i < size; ++i) {
+        nk_uint i = (nk_uint)((name >> shift) % NK_VALUE_PAGE_CAPACITY);
+        while (iter->used[i/32] & (1u << (i % 32))) {
             if (iter->keys[i] == name) {
                 iter->seq = win->seq;
                 return &iter->values[i];
             }
+            i = (nk_uint)((i + 1) % NK_VALUE_PAGE_CAPACITY);
         }
-        size = NK_VALUE_PAGE_CAPACITY;
-        iter = iter->next;
+        iter = iter->next[(name >> shift) % NK_VALUE_PAGE_CHILDREN];
+        shift += 4;
     }
     return 0;
 }
@@ -14837,7 +19364,6 @@ NK_INTERN void
 nk_free_window(struct nk_context *ctx, struct nk_window *win)
 {
     /* unlink windows from list */
-    struct nk_table *n, *it = win->tables;
     if (win->popup.win) {
         nk_free_window(ctx, win->popup.win);
         win->popup.win = 0;
@@ -14845,15 +19371,8 @@ nk_free_window(struct nk_context *ctx, struct nk_window *win)
     win->next = 0;
     win->prev = 0;
 
-    while (it) {
-        /*free window state tables */
-        n = it->next;
-        nk_remove_table(win, it);
-        nk_free_table(ctx, it);
-        if (it == win->tables)
-            win->tables = n;
-        it = n;
-    }
+    /*free window state tables */
+    nk_free_tables(ctx, win, &win->tables, nk_false);
 
     /* link windows into freelist */
     {union nk_page_data *pd = NK_CONTAINER_OF(win, union nk_page_data, win);
@@ -14861,10 +19380,133 @@ nk_free_window(struct nk_context *ctx, struct nk_window *win)
     nk_free_page_element(ctx, pe);}
 }
 
+NK_INTERN struct nk_pool*
+nk_window_map(struct nk_context *ctx)
+{
+    /* window hash map is only kept for dynamically allocated pools */
+    struct nk_pool *pool = (struct nk_pool*)ctx->pool;
+    if (!pool || pool->type != NK_BUFFER_DYNAMIC) return 0;
+    return pool;
+}
+
+NK_INTERN struct nk_window_slot*
+nk_window_map_slot(struct nk_pool *pool, const struct nk_window *win)
+{
+    unsigned int mask, i;
+    if (!pool->windows) return 0;
+    mask = pool->window_capacity - 1;
+    i = win->name & mask;
+    while (pool->windows[i].win) {
+        if (pool->windows[i].win == win)
+            return &pool->windows[i];
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+NK_INTERN void
+nk_window_map_put(struct nk_window_slot *slots, unsigned int capacity,
+    struct nk_window *win)
+{
+    unsigned int mask = capacity - 1;
+    unsigned int i = win->name & mask;
+    while (slots[i].win)
+        i = (i + 1) & mask;
+    slots[i].name = win->name;
+    slots[i].win = win;
+}
+
+NK_INTERN void
+nk_window_map_rebuild(struct nk_context *ctx, struct nk_pool *pool,
+    unsigned int capacity)
+{
+    /* reallocate the map and rehash all windows currently in the window list.
+     * If allocation fails the map is dropped and lookups fall back to the list */
+    struct nk_window *iter;
+    struct nk_window_slot *slots;
+    nk_size size = capacity * sizeof(struct nk_window_slot);
+    slots = (struct nk_window_slot*)pool->alloc.alloc(pool->alloc.userdata, 0, size);
+    NK_ASSERT(slots);
+    if (pool->windows)
+        pool->alloc.free(pool->alloc.userdata, pool->windows);
+    pool->windows = 0;
+    pool->window_capacity = 0;
+    pool->window_count = 0;
+    if (!slots) return;
+
+    nk_zero(slots, size);
+    for (iter = ctx->begin; iter; iter = iter->next) {
+        nk_window_map_put(slots, capacity, iter);
+        pool->window_count++;
+    }
+    pool->windows = slots;
+    pool->window_capacity = capacity;
+}
+
+NK_INTERN void
+nk_window_map_insert(struct nk_context *ctx, struct nk_window *win)
+{
+    struct nk_pool *pool = nk_window_map(ctx);
+    if (!pool) return;
+    if ((pool->window_count + 1) * 2 > pool->window_capacity) {
+        /* keep load factor below one half (window is already linked into the list) */
+        unsigned int capacity = (pool->window_capacity) ?
+            pool->window_capacity: NK_WINDOW_MAP_INITIAL_CAPACITY;
+        while (ctx->count * 2 > capacity)
+            capacity *= 2;
+        nk_window_map_rebuild(ctx, pool, capacity);
+        return;
+    }
+    nk_window_map_put(pool->windows, pool->window_capacity, win);
+    pool->window_count++;
+}
+
+NK_INTERN void
+nk_window_map_remove(struct nk_context *ctx, struct nk_window *win)
+{
+    struct nk_window_slot *slot;
+    unsigned int mask, i, j;
+    struct nk_pool *pool = nk_window_map(ctx);
+    if (!pool) return;
+    slot = nk_window_map_slot(pool, win);
+    if (!slot) return;
+
+    /* backward shift deletion: move following entries of the probe
+     * sequence into the hole so lookups never need tombstones */
+    mask = pool->window_capacity - 1;
+    i = (unsigned int)(slot - pool->windows);
+    j = i;
+    while (1) {
+        unsigned int home;
+        j = (j + 1) & mask;
+        if (!pool->windows[j].win) break;
+        home = pool->windows[j].name & mask;
+        if ((i <= j) ? (home <= i || home > j): (home <= i && home > j)) {
+            pool->windows[i] = pool->windows[j];
+            i = j;
+        }
+    }
+    pool->windows[i].name = 0;
+    pool->windows[i].win = 0;
+    pool->window_count--;
+}
+
 NK_INTERN struct nk_window*
 nk_find_window(struct nk_context *ctx, nk_hash hash)
 {
     struct nk_window *iter;
+    struct nk_pool *pool = nk_window_map(ctx);
+    if (pool && pool->windows) {
+        unsigned int mask = pool->window_capacity - 1;
+        unsigned int i = hash & mask;
+        while (pool->windows[i].win) {
+            if (pool->windows[i].name == hash)
+                return pool->windows[i].win;
+            i = (i + 1) & mask;
+        }
+        return 0;
+    }
+
     iter = ctx->begin;
     while (iter) {
         NK_ASSERT(iter != iter->next);
@@ -14880,16 +19522,23 @@ nk_insert_window(struct nk_context *ctx, struct nk_window *win)
 {
     const struct nk_window *iter;
     struct nk_window *end;
+    struct nk_pool *pool;
     NK_ASSERT(ctx);
     NK_ASSERT(win);
     if (!win || !ctx) return;
 
-    iter = ctx->begin;
-    while (iter) {
-        NK_ASSERT(iter != iter->next);
-        NK_ASSERT(iter != win);
-        if (iter == win) return;
-        iter = iter->next;
+    pool = nk_window_map(ctx);
+    if (pool && pool->windows) {
+        NK_ASSERT(!nk_window_map_slot(pool, win));
+        if (nk_window_map_slot(pool, win)) return;
+    } else {
+        iter = ctx->begin;
+        while (iter) {
+            NK_ASSERT(iter != iter->next);
+            NK_ASSERT(iter != win);
+            if (iter == win) return;
+            iter = iter->next;
+        }
     }
 
     if (!ctx->begin) {
@@ -14898,6 +19547,7 @@ nk_insert_window(struct nk_context *ctx, struct nk_window *win)
         ctx->begin = win;
         ctx->end = win;
         ctx->count = 1;
+        nk_window_map_insert(ctx, win);
         return;
     }
 
@@ -14908,6 +19558,7 @@ nk_insert_window(struct nk_context *ctx, struct nk_window *win)
     win->next = 0;
     ctx->end = win;
     ctx->count++;
+    nk_window_map_insert(ctx, win);
 
     ctx->active = ctx->end;
     ctx->end->flags &= ~(nk_flags)NK_WINDOW_ROM;
@@ -14941,6 +19592,7 @@ nk_remove_window(struct nk_context *ctx, struct nk_window *win)
     win->next = 0;
     win->prev = 0;
     ctx->count--;
+    nk_window_map_remove(ctx, win);
 }
 
 NK_API int
@@ -14969,12 +19621,12 @@ nk_begin(struct nk_context *ctx, struct nk_panel *layout, const char *title,
         win = (struct nk_window*)nk_create_window(ctx);
         NK_ASSERT(win);
         if (!win) return 0;
+        win->name = title_hash;
         nk_insert_window(ctx, win);
         nk_command_buffer_init(&win->buffer, &ctx->memory, NK_CLIPPING_ON);
 
         win->flags = flags;
         win->bounds = bounds;
-        win->name = title_hash;
         win->popup.win = 0;
         if (!ctx->active)
             ctx->active = win;
@@ -15470,6 +20122,11 @@ nk_panel_begin(struct nk_context *ctx, const char *title)
 #ifdef NK_INCLUDE_COMMAND_USERDATA
     win->buffer.userdata = ctx->userdata;
 #endif
+#if NK_TEXT_CACHE_CAPACITY > 0
+    win->buffer.text_cache = &ctx->text_cache;
+#else
+    win->buffer.text_cache = 0;
+#endif
 
     /* window dragging */
     if ((win->flags & NK_WINDOW_MOVABLE) && !(win->flags & NK_WINDOW_ROM)) {
@@ -15645,7 +20302,7 @@ nk_panel_begin(struct nk_context *ctx, const char *title)
             /* window header title */
             int text_len = nk_strlen(title);
             struct nk_rect label = {0,0,0,0};
-            float t = font->width(font->userdata, font->height, title, text_len);
+            float t = nk_text_width(out->text_cache, font, title, text_len);
 
             label.x = header.x + style->window.header.padding.x;
             label.x += style->window.header.label_padding.x;
@@ -17665,6 +22322,9 @@ nk_edit_string(struct nk_context *ctx, nk_flags flags,
     nk_flags state;
     struct nk_text_edit *edit;
     struct nk_window *win;
+    struct nk_edit_lines *lines;
+    struct nk_text_edit_lines swap;
+    int i;
 
     NK_ASSERT(ctx);
     NK_ASSERT(memory);
@@ -17701,8 +22361,41 @@ nk_edit_string(struct nk_context *ctx, nk_flags flags,
     nk_str_init_fixed(&edit->string, memory, (nk_size)max);
     edit->string.buffer.allocated = (nk_size)*len;
     edit->string.len = nk_utf_len(memory, *len);
+
+    /* swap in the line index of this widget, which is only trusted
+     * if the text length did not change since it was built */
+    lines = &ctx->edit_lines[0];
+    for (i = 0; i < NK_EDIT_LINES_CACHE; ++i) {
+        struct nk_edit_lines *l = &ctx->edit_lines[i];
+        if (l->used && l->window == win->name && l->widget == hash) {
+            lines = l;
+            break;
+        }
+        if (l->used < lines->used)
+            lines = l;
+    }
+    if (i == NK_EDIT_LINES_CACHE || lines->length != *len ||
+        lines->runes != edit->string.len) {
+        lines->window = win->name;
+        lines->widget = hash;
+        lines->lines.count = 0;
+        lines->lines.complete = 0;
+    }
+    lines->used = ++ctx->edit_lines_clock;
+    lines->lines.version = edit->string.version;
+    swap = edit->lines;
+    edit->lines = lines->lines;
+
     state = nk_edit_buffer(ctx, flags, edit, filter);
     *len = (int)edit->string.buffer.allocated;
+    if (edit->lines.complete && edit->lines.version != edit->string.version) {
+        edit->lines.count = 0;
+        edit->lines.complete = 0;
+    }
+    lines->lines = edit->lines;
+    lines->length = *len;
+    lines->runes = edit->string.len;
+    edit->lines = swap;
 
     if (edit->active) {
         win->edit.cursor = edit->cursor;